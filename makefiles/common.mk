@@ -14,6 +14,7 @@ DEVDEBUG ?= yes
 # TARGET is the name of the output
 # BUILD is the directory where object files & intermediate files will be placed
 # SOURCES is a list of directories containing source code
+# SOURCE_FILES is a list of extra individual source files to compile
 # INCLUDES is a list of directories containing extra header files
 # DATA is a list of directories containing binary data
 # GRAPHICS is a list of directories containing files to be processed by grit
@@ -48,6 +49,11 @@ ifeq ($(DEVDEBUG),yes)
   CFLAGS += -DDEVDEBUG
 endif
 
+# size of the entity pool. leave empty for the default (see game.h)
+ifneq ($(ENTITY_CAPACITY),)
+  CFLAGS += -DMAX_ENTITY_COUNT=$(ENTITY_CAPACITY)
+endif
+
 CXXFLAGS := $(CFLAGS) -fno-rtti -fno-exceptions
 
 
@@ -64,7 +70,8 @@ export DEPSDIR	:=	$(CURDIR)/$(BUILD)
 # evaluates to an empty string)
 export TOPLEVEL := $(CURDIR)/
 
-CFILES		:=	$(foreach dir,$(SOURCES),$(wildcard $(dir)/*.c))
+CFILES		:=	$(foreach dir,$(SOURCES),$(wildcard $(dir)/*.c))\
+				$(filter %.c,$(SOURCE_FILES))
 CPPFILES	:=	$(foreach dir,$(SOURCES),$(wildcard $(dir)/*.cpp))
 SFILES		:=	$(foreach dir,$(SOURCES),$(wildcard $(dir)/*.s))
 PNGFILES	:=	$(foreach dir,$(GRAPHICS),$(wildcard $(dir)/*.png))
@@ -87,7 +94,7 @@ ifneq ($(strip $(MUSIC)),)
 endif
 
 BINFILES += data/sinelut.bin data/dlg.bin data/pitchlut.bin data/wave_tri.bin\
-            data/wave_noise.bin data/color_qlut.bin
+            data/wave_noise.bin data/color_fade.bin
 
 #---------------------------------------------------------------------------------
 # use CXX for linking C++ projects, CC for standard C
@@ -282,9 +289,11 @@ endif
 	@echo $<
 	$(bin2o)
 
-%.map: %.tmx $(TOPLEVEL)/tools/mapc.py
+%.map: %.tmx $(TOPLEVEL)/tools/mapc.py $(TOPLEVEL)/tools/lz77.py \
+       $(TOPLEVEL)/data/dialogue.json
 	@mkdir -p $(dir $@)
-	$(SILENTCMD)$(PYTHON) $(TOPLEVEL)/tools/mapc.py $< $@
+	$(SILENTCMD)$(PYTHON) $(TOPLEVEL)/tools/mapc.py $< $@ \
+		--dialogue $(TOPLEVEL)/data/dialogue.json
 
 #---------------------------------------------------------------------------------
 # This rule compiles .sprdb files to a sprdb binary data and image file, using
@@ -314,7 +323,8 @@ endif
 #---------------------------------------------------------------------------------
 data/world.c data/world.h data/automap.bin &:\
     $(MAPFILES) $(TOPLEVEL)/data/maps/unyuland.world\
-	$(TOPLEVEL)/data/room_list.txt $(TOPLEVEL)/tools/worldproc.py
+	$(TOPLEVEL)/data/room_list.txt $(TOPLEVEL)/tools/worldproc.py\
+	$(TOPLEVEL)/tools/lz77.py
 #---------------------------------------------------------------------------------
 	@mkdir -p $(dir $@)
 	
@@ -372,12 +382,12 @@ data/wave_noise.bin: $(TOPLEVEL)/tools/wavetable.py
 	$(SILENTCMD)$(PYTHON) $(TOPLEVEL)/tools/wavetable.py -w noise $@
 
 #---------------------------------------------------------------------------------
-# This rule precomputes the color quantization look-up table
+# This rule precomputes the palette for each level of a fade
 #---------------------------------------------------------------------------------
-data/color_qlut.bin: $(TOPLEVEL)/tools/color.py
+data/color_fade.bin: $(TOPLEVEL)/tools/color.py
 #---------------------------------------------------------------------------------
 	@mkdir -p $(dir $@)
-	$(SILENTCMD)$(PYTHON) $(TOPLEVEL)/tools/color.py qlut -o $@
+	$(SILENTCMD)$(PYTHON) $(TOPLEVEL)/tools/color.py fadelut -o $@
 
 
 # make likes to delete intermediate files. This prevents it from deleting the
@@ -0,0 +1,65 @@
+CC ?= gcc
+DEVDEBUG ?= no
+
+TARGET       := unyuland-headless
+BUILD        := buildheadless
+
+LIBXMP := third_party/libxmp
+
+#---------------------------------------------------------------------------------
+# platform-specific sources
+# the headless runner uses the same tonc shims and audio code as the pc build,
+# but none of the SDL frontend.
+#---------------------------------------------------------------------------------
+SOURCES := src/pc/tonc src/headless
+SOURCE_FILES := src/pc/modplay.c src/pc/psg.c src/pc/mgba.c
+INCLUDES := src/pc/include $(LIBXMP)/include
+
+#---------------------------------------------------------------------------------
+# any extra libraries we wish to link with the project
+#---------------------------------------------------------------------------------
+SLIBS        := libxmp-lite.a
+LIBS         := $(SLIBS) -lm
+
+
+#---------------------------------------------------------------------------------
+# options for code generation
+# non-PIE, so that addresses of static data (which can end up in entity
+# userdata) stay the same between runs. otherwise the state hashes would differ.
+#---------------------------------------------------------------------------------
+CFLAGS  := -DPLATFORM_PC -DPLATFORM_HEADLESS -O2 -fno-pie $(CFLAGS)
+ASFLAGS := -DPLATFORM_PC -DPLATFORM_HEADLESS $(ASFLAGS)
+LDFLAGS := -no-pie $(LDFLAGS)
+
+ifeq ($(DEVDEBUG),yes)
+  CFLAGS += -gdwarf-4
+  LDFLAGS += -gdwarf-4
+endif
+
+
+#---------------------------------------------------------------------------------
+# targets
+#---------------------------------------------------------------------------------
+define CLEAN =
+@rm -fr $(BUILD) $(OUTPUT)
+endef
+
+define BUILD_TARGETS
+$(OUTPUT): $(OFILES) $(SLIBS)
+	$(SILENTCMD)$(CC) $(OFILES) $(LDFLAGS) $(CFLAGS) $(LIBS) -o $(OUTPUT)
+
+libxmp-lite.a: $(TOPLEVEL)/$(LIBXMP)/lib/libxmp-lite.a
+	$(SILENTCMD)cp $(TOPLEVEL)/$(LIBXMP)/lib/libxmp-lite.a $(CURDIR)
+endef
+
+#---------------------------------------------------------------------------------
+# This rule creates C source files using grit
+#---------------------------------------------------------------------------------
+%_gfx.c %_gfx.h: %.png %.grit
+#---------------------------------------------------------------------------------
+	@mkdir -p $(dir $*)
+	@grit $< -ftc -o$*_gfx
+
+
+#---------------------------------------------------------------------------------
+include $(TOPLEVEL)makefiles/common.mk
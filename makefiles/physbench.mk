@@ -0,0 +1,66 @@
+CC ?= gcc
+DEVDEBUG ?= no
+ENTITY_CAPACITY ?= 128
+
+TARGET       := unyuland-physbench
+BUILD        := buildphysbench
+
+LIBXMP := third_party/libxmp
+
+#---------------------------------------------------------------------------------
+# platform-specific sources
+# the physics benchmark is built like the headless runner, just with a
+# different entry point.
+#---------------------------------------------------------------------------------
+SOURCES := src/pc/tonc src/physbench
+SOURCE_FILES := src/pc/modplay.c src/pc/psg.c src/pc/mgba.c
+INCLUDES := src/pc/include $(LIBXMP)/include
+
+#---------------------------------------------------------------------------------
+# any extra libraries we wish to link with the project
+#---------------------------------------------------------------------------------
+SLIBS        := libxmp-lite.a
+LIBS         := $(SLIBS) -lm
+
+
+#---------------------------------------------------------------------------------
+# options for code generation
+# PHYS_PROFILE_QUIET keeps the physics profiler from logging every frame.
+#---------------------------------------------------------------------------------
+CFLAGS  := -DPLATFORM_PC -DPLATFORM_HEADLESS -DPHYS_PROFILE -DPHYS_PROFILE_QUIET \
+           -O2 -fno-pie $(CFLAGS)
+ASFLAGS := -DPLATFORM_PC -DPLATFORM_HEADLESS $(ASFLAGS)
+LDFLAGS := -no-pie $(LDFLAGS)
+
+ifeq ($(DEVDEBUG),yes)
+  CFLAGS += -gdwarf-4
+  LDFLAGS += -gdwarf-4
+endif
+
+
+#---------------------------------------------------------------------------------
+# targets
+#---------------------------------------------------------------------------------
+define CLEAN =
+@rm -fr $(BUILD) $(OUTPUT)
+endef
+
+define BUILD_TARGETS
+$(OUTPUT): $(OFILES) $(SLIBS)
+	$(SILENTCMD)$(CC) $(OFILES) $(LDFLAGS) $(CFLAGS) $(LIBS) -o $(OUTPUT)
+
+libxmp-lite.a: $(TOPLEVEL)/$(LIBXMP)/lib/libxmp-lite.a
+	$(SILENTCMD)cp $(TOPLEVEL)/$(LIBXMP)/lib/libxmp-lite.a $(CURDIR)
+endef
+
+#---------------------------------------------------------------------------------
+# This rule creates C source files using grit
+#---------------------------------------------------------------------------------
+%_gfx.c %_gfx.h: %.png %.grit
+#---------------------------------------------------------------------------------
+	@mkdir -p $(dir $*)
+	@grit $< -ftc -o$*_gfx
+
+
+#---------------------------------------------------------------------------------
+include $(TOPLEVEL)makefiles/common.mk
@@ -0,0 +1,404 @@
+// headless runner. runs the game loop without a window or audio output,
+// feeding it a recorded REG_KEYINPUT stream, and writes a hash of the game
+// state for every frame. used for benchmarking and for catching determinism
+// regressions.
+//
+// an input recording is just a sequence of little-endian u16 REG_KEYINPUT
+// values, one per frame. the pc build can make one with --record <path>.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <log.h>
+
+#include <tonc.h>
+#include <modplay.h>
+#include <platctl.h>
+
+#include <data/world.h>
+#include "game.h"
+
+// sample rate is chosen so that a frame is exactly a whole number of samples
+#define FRAME_SAMPLES 546
+#define SAMPLE_RATE (FRAME_SAMPLES * 60)
+
+#define FNV_OFFSET 0xCBF29CE484222325ull
+#define FNV_PRIME  0x100000001B3ull
+
+// these functions are defined by src/main/main.c
+void platform_app_init(void);
+void platform_app_frame(void);
+bool platform_app_save_state(void);
+void platform_app_load_state(void);
+
+static mp_s16 s_audio_buf[FRAME_SAMPLES * 2];
+
+
+
+
+
+
+
+
+
+
+//------------------------------------------------------------------------------
+// platctl
+//------------------------------------------------------------------------------
+#pragma region platctl
+
+void platctl_set_volume(unsigned int volume) {}
+void platctl_set_fullscreen(bool fulscr) {}
+bool platctl_get_fullscreen(void) { return false; }
+void platctl_set_fullscreen_change_watcher(platctl_fulscr_change_watcher_f fun)
+{}
+
+#pragma endregion platctl
+
+
+
+
+
+
+
+
+
+
+//------------------------------------------------------------------------------
+// state hash
+//------------------------------------------------------------------------------
+#pragma region state hash
+
+// 64-bit FNV-1a
+static inline u64 hash_bytes(u64 h, const void *data, size_t size)
+{
+    const u8 *p = data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= p[i];
+        h *= FNV_PRIME;
+    }
+
+    return h;
+}
+
+static inline u64 hash_u32(u64 h, u32 v)
+{
+    u8 b[4] = { v, v >> 8, v >> 16, v >> 24 };
+    return hash_bytes(h, b, sizeof(b));
+}
+
+// defined by the gnu linker. weak, so that they are just NULL elsewhere.
+extern const char __executable_start[] __attribute__((weak));
+extern const char _end[] __attribute__((weak));
+
+// entity userdata and some fields of g_game can hold pointers, which change
+// between builds. pointers into g_game are hashed as offsets, and pointers to
+// anything else in the executable (behavior tables, dialogue strings, ...)
+// only count as "some pointer", so hashes from two different builds can still
+// be compared. everything else is hashed as-is.
+static u64 hash_word(u64 h, uintptr_t v)
+{
+    const uintptr_t game_start = (uintptr_t)&g_game;
+    const uintptr_t game_end = (uintptr_t)(&g_game + 1);
+
+    if (v >= game_start && v < game_end)
+    {
+        h = hash_u32(h, 1);
+        return hash_u32(h, (u32)(v - game_start));
+    }
+
+    if (__executable_start && _end &&
+        v >= (uintptr_t)__executable_start && v < (uintptr_t)_end)
+    {
+        return hash_u32(h, 2);
+    }
+
+    h = hash_u32(h, 0);
+    h = hash_u32(h, (u32)v);
+    return hash_u32(h, (u32)((u64)v >> 32));
+}
+
+static u64 hash_entity(u64 h, const entity_s *ent)
+{
+    // sleeping is only an optimization, it isn't part of the game state
+    h = hash_u32(h, ent->flags & ~ENTITY_FLAG_SLEEPING);
+    if (!(ent->flags & ENTITY_FLAG_ENABLED)) return h;
+
+    h = hash_u32(h, ent->pos.x);
+    h = hash_u32(h, ent->pos.y);
+    h = hash_u32(h, ent->vel.x);
+    h = hash_u32(h, ent->vel.y);
+    h = hash_u32(h, ent->gmult);
+    h = hash_u32(h, ent->damp);
+    h = hash_u32(h, ent->mass | (ent->health << 8));
+
+    h = hash_u32(h, ent->col.flags | (ent->col.w << 16) | (ent->col.h << 24));
+    h = hash_u32(h, ent->col.group | (ent->col.mask << 16));
+
+    h = hash_u32(h, ent->actor.flags | ((u8)ent->actor.move_x << 8) |
+                    ((u8)ent->actor.face_dir << 16) |
+                    (ent->actor.jump_trigger << 24));
+    h = hash_u32(h, ent->actor.move_speed);
+    h = hash_u32(h, ent->actor.move_accel);
+    h = hash_u32(h, ent->actor.jump_velocity);
+
+    h = hash_u32(h, ent->sprite.flags | (ent->sprite.graphic_id << 8) |
+                    (ent->sprite.frame << 16) | (ent->sprite.accum << 24));
+    h = hash_u32(h, (u8)ent->sprite.zidx | ((u8)ent->sprite.palette << 8));
+    h = hash_u32(h, (u16)ent->sprite.ox | ((u16)ent->sprite.oy << 16));
+
+    h = hash_word(h, (uintptr_t)ent->behavior);
+    for (int i = 0; i < 4; ++i)
+        h = hash_word(h, ent->userdata[i]);
+
+    return h;
+}
+
+static u64 hash_projectile(u64 h, const projectile_s *proj)
+{
+    h = hash_u32(h, proj->flags);
+    if (!IS_PROJ_ACTIVE(proj)) return h;
+
+    h = hash_u32(h, proj->kind | (proj->graphic_id << 8) |
+                    (proj->did_touch_this_frame << 16));
+    h = hash_u32(h, proj->life);
+    h = hash_u32(h, proj->px);
+    h = hash_u32(h, proj->py);
+    h = hash_u32(h, proj->vx);
+    h = hash_u32(h, proj->vy);
+    h = hash_u32(h, proj->g);
+
+    return h;
+}
+
+static u64 hash_game_state(void)
+{
+    u64 h = FNV_OFFSET;
+
+    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+        h = hash_entity(h, g_game.entities + i);
+
+    for (int i = 0; i < MAX_PROJECTILE_COUNT; ++i)
+        h = hash_projectile(h, g_game.projectiles + i);
+
+    int room_idx = g_game.room ? (int)(g_game.room - world_rooms) : -1;
+    h = hash_u32(h, room_idx);
+    h = hash_u32(h, g_game.room_player_x);
+    h = hash_u32(h, g_game.room_player_y);
+    h = hash_u32(h, g_game.cam_x);
+    h = hash_u32(h, g_game.cam_y);
+    h = hash_u32(h, g_game.cam_data.move_y);
+    h = hash_u32(h, g_game.cam_data.rel_x);
+    h = hash_u32(h, g_game.cam_data.target_y);
+
+    h = hash_u32(h, g_game.input_enabled | (g_game.queue_restore << 1) |
+                    (g_game.player_is_dead << 2) |
+                    (g_game.did_collect_orb << 3) |
+                    (g_game.dialogue_active << 4) |
+                    (g_game.did_jingle_finish << 5));
+
+    h = hash_u32(h, g_game.room_trans.phase);
+    h = hash_u32(h, g_game.room_trans.ticks);
+
+    h = hash_word(h, (uintptr_t)g_game.active_water_tank);
+    h = hash_word(h, (uintptr_t)g_game.active_interactable);
+    h = hash_u32(h, g_game.active_interactable_timer);
+
+    h = hash_u32(h, g_game.player_ammo);
+    h = hash_u32(h, g_game.player_spit_mode);
+    h = hash_u32(h, g_game.collected_rorbs | (g_game.collected_borbs << 8) |
+                    (g_game.committed_collected_rorbs << 16) |
+                    (g_game.committed_collected_borbs << 24));
+    h = hash_u32(h, g_game.collected_orbs_count);
+    h = hash_u32(h, g_game.cur_music);
+
+    return h;
+}
+
+#pragma endregion state hash
+
+
+
+
+
+
+
+
+
+
+//------------------------------------------------------------------------------
+// lifecycle
+//------------------------------------------------------------------------------
+#pragma region lifecycle
+
+static u64 get_ticks_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+static u16* load_recording(const char *path, size_t *out_frame_count)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "could not open %s\n", path);
+        return NULL;
+    }
+
+    long size = -1;
+    if (fseek(f, 0, SEEK_END) == 0)
+        size = ftell(f);
+    if (size < 0 || fseek(f, 0, SEEK_SET) != 0)
+    {
+        fprintf(stderr, "could not get the size of %s\n", path);
+        fclose(f);
+        return NULL;
+    }
+
+    size_t frame_count = (size_t)size / 2;
+    u16 *frames = malloc((frame_count + 1) * sizeof(u16));
+    if (!frames)
+    {
+        fprintf(stderr, "out of memory loading %s\n", path);
+        fclose(f);
+        return NULL;
+    }
+
+    u8 b[2];
+    for (size_t i = 0; i < frame_count; ++i)
+    {
+        if (fread(b, 1, 2, f) != 2)
+        {
+            frame_count = i;
+            break;
+        }
+
+        frames[i] = (u16)(b[0] | (b[1] << 8));
+    }
+
+    fclose(f);
+    *out_frame_count = frame_count;
+    return frames;
+}
+
+static void usage(const char *exe)
+{
+    fprintf(stderr,
+        "usage: %s [options] <recording>\n"
+        "options:\n"
+        "  -o <path>  write per-frame state hashes to path (default: stdout)\n"
+        "  -n <count> number of frames to run. if this is longer than the\n"
+        "             recording, the rest is run with no keys held.\n"
+        "  -q         only print the hash of the last frame\n"
+        "  -r <count> run ahead this many frames after every frame, the way\n"
+        "             the pc build does, and then undo them. the hashes\n"
+        "             should come out the same as without it.\n",
+        exe);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *rec_path = NULL;
+    const char *out_path = NULL;
+    long run_frames = -1;
+    int run_ahead = 0;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-o") && i + 1 < argc)
+            out_path = argv[++i];
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc)
+            run_frames = strtol(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+            run_ahead = (int) strtol(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-q"))
+            quiet = true;
+        else if (argv[i][0] != '-' && !rec_path)
+            rec_path = argv[i];
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!rec_path)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    size_t rec_frames;
+    u16 *rec = load_recording(rec_path, &rec_frames);
+    if (!rec) return 1;
+
+    if (run_frames < 0)
+        run_frames = (long)rec_frames;
+
+    FILE *out = stdout;
+    if (out_path)
+    {
+        out = fopen(out_path, "w");
+        if (!out)
+        {
+            fprintf(stderr, "could not open %s\n", out_path);
+            return 1;
+        }
+    }
+
+    mplay_set_sample_rate(SAMPLE_RATE);
+
+    REG_KEYINPUT = KEY_MASK;
+    platform_app_init();
+
+    u64 sim_time = 0;
+    u64 hash = 0;
+
+    for (long frame = 0; frame < run_frames; ++frame)
+    {
+        REG_KEYINPUT = (size_t)frame < rec_frames ? rec[frame] : KEY_MASK;
+
+        u64 start_time = get_ticks_ns();
+        platform_app_frame();
+
+        if (run_ahead > 0 && platform_app_save_state())
+        {
+            for (int i = 0; i < run_ahead; ++i)
+                platform_app_frame();
+
+            platform_app_load_state();
+        }
+
+        sim_time += get_ticks_ns() - start_time;
+
+        // music still needs to play, since the game waits for jingles to end.
+        // render exactly one frame of audio per frame, so that songs end on
+        // the same frame every run.
+        mplay_render(s_audio_buf, FRAME_SAMPLES);
+
+        hash = hash_game_state();
+        if (!quiet)
+            fprintf(out, "%ld %016llx\n", frame, (unsigned long long)hash);
+    }
+
+    if (quiet)
+        fprintf(out, "%016llx\n", (unsigned long long)hash);
+
+    fprintf(stderr, "%ld frames, %.3f ms (%.0f ns/frame)\n", run_frames,
+            (double)sim_time / 1e6,
+            run_frames > 0 ? (double)sim_time / (double)run_frames : 0.0);
+
+    if (out != stdout) fclose(out);
+    free(rec);
+    mplay_deinit();
+
+    return 0;
+}
+
+#pragma endregion lifecycle
@@ -37,6 +37,10 @@ void mplay_set_sample_rate(mp_uint sample_rate);
 
 // audio is rendered as 8-bit into the space of a 16-bit integer
 void mplay_render(mp_s16 *data, mp_size frame_count);
+
+// while locked, calls that change playback are ignored. run-ahead locks it
+// while running frames that are going to be undone.
+void mplay_set_locked(mp_bool locked);
 #endif
 
 void mplay_start(mp_uint module_id, mp_bool loop);
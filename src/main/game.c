@@ -1,4 +1,6 @@
 #include <stdlib.h>
+#include <stddef.h>
+#include <limits.h>
 #include <tonc.h>
 #include <string.h>
 #include <modplay.h>
@@ -9,17 +11,34 @@
 
 #include "game.h"
 #include "game_physics.h"
+#include "game_query.h"
+#include "game_rewind.h"
 #include "gfx.h"
 #include "math_util.h"
+#include "savestate.h"
+#include "lz77.h"
 
 #define MAX_RENDER_OBJS ((MAX_ENTITY_COUNT + MAX_PROJECTILE_COUNT))
 #define FREE_QUEUE_MAX_SIZE 32
 
 // 1 KiB for the copy of the map collision. stored in ewram.
+// tools/mapc.py rejects rooms that don't fit this or GAME_COLMASK_SIZE, so
+// keep them in sync.
 #define GAME_COLLISION_MAP_SIZE (1024)
 
+// size of the decompressed room graphics, in screen entries. that's one per
+// tile, so it fits as many tiles as the collision map does.
+#define GAME_ROOM_GFX_SIZE (GAME_COLLISION_MAP_SIZE * 4)
+
+// size of each collision bitmask index, in words. 1 KiB each, which fits a
+// 64x128 room.
+#define GAME_COLMASK_SIZE (256)
+
 #define GAME_BG_IDX 1
 
+// length of the fade out before switching rooms, in frames
+#define ROOM_TRANS_FADE_TICKS 30
+
 #define RAINBOW_PALETTE_LENGTH (sizeof(rainbow_pal) / sizeof(*rainbow_pal))
 
 typedef enum render_obj_t
@@ -36,10 +55,9 @@ typedef struct render_obj
 }
 render_obj_s;
 
-typedef struct game_state
+// the parts of g_game that get saved along with the entities and projectiles
+typedef struct game_state_props
 {
-    entity_s entities[MAX_ENTITY_COUNT];
-    projectile_s projectiles[MAX_PROJECTILE_COUNT];
     FIXED cam_x, cam_y;
     game_camera_s cam_data;
     room_trans_state_s room_trans;
@@ -50,15 +68,61 @@ typedef struct game_state
     u8 collected_rorbs;
     u8 collected_borbs;
 }
+game_state_props_s;
+
+typedef struct game_state
+{
+    entity_s entities[MAX_ENTITY_COUNT];
+    projectile_s projectiles[MAX_PROJECTILE_COUNT];
+    game_state_props_s props;
+}
 game_state_s;
 
 game_s g_game;
 EWRAM_BSS game_state_s game_saved_state;
-EWRAM_BSS static u8 game_room_collision[GAME_COLLISION_MAP_SIZE];
+
+// there are two sets of room collision and graphics buffers. the current room
+// uses one, and the room the player is heading into gets staged into the other
+// during the room transition fade, a few rows a frame.
+EWRAM_BSS static u8 game_room_collision[2][GAME_COLLISION_MAP_SIZE];
+EWRAM_BSS static u32 game_room_solid_mask[2][GAME_COLMASK_SIZE];
+EWRAM_BSS static u32 game_room_water_mask[2][GAME_COLMASK_SIZE];
+EWRAM_BSS static u16 game_room_gfx[2][GAME_ROOM_GFX_SIZE];
+static int room_buf; // the set the current room uses
+
+// how many collision mask rows get built per frame of the fade. a 64x128 room
+// takes 16 frames at this rate, and the fade is 30. whatever's left when the
+// room actually loads is done then.
+#define ROOM_PREFETCH_ROWS_PER_FRAME 8
+
+static struct
+{
+    const world_room_s *room; // NULL if nothing is staged
+    int rows_built;
+
+    // the graphics are decompressed along with the mask rows. for rooms that
+    // aren't compressed, this just points at the room data.
+    const u16 *gfx_data;
+    lz77_stream_s gfx_stream;
+} room_prefetch;
 
 static uint render_object_count = 0;
 static render_obj_s render_objects[MAX_RENDER_OBJS];
 
+// free slots of the entity and projectile pools, one bit per slot. allocating
+// takes the lowest free slot, same as scanning the pool for one would.
+#define PROJ_FREE_MASK_WORDS CEIL_DIV(MAX_PROJECTILE_COUNT, 32)
+
+static u32 ent_free_mask[ENTITY_MASK_WORDS];
+static u32 proj_free_mask[PROJ_FREE_MASK_WORDS];
+
+// slots that may differ from game_saved_state, one bit per slot. a slot that
+// stayed free since the last save or restore can't have changed, so this is
+// every slot that was in use at that point, plus the ones allocated since.
+// only these get copied when saving or restoring.
+static u32 ent_dirty_mask[ENTITY_MASK_WORDS];
+static u32 proj_dirty_mask[PROJ_FREE_MASK_WORDS];
+
 static int ent_free_queue_count = 0;
 static entity_s *ent_free_queue[FREE_QUEUE_MAX_SIZE];
 
@@ -88,10 +152,89 @@ static void update_rainbow_palette(void)
 }
 
 static bool game_transition_update(entity_s *player);
+static void rewind_reset(void);
+static void rewind_capture(void);
+static void rewind_step(void);
+static void room_transition_prefetch_screen(const entity_s *player);
+
+static void pool_mask_fill(u32 *mask, int words, int slot_count)
+{
+    for (int i = 0; i < words; ++i)
+    {
+        int n = slot_count - i * 32;
+        mask[i] = (n >= 32) ? UINT32_MAX : (1u << n) - 1;
+    }
+}
+
+// returns the lowest free slot, or -1 if there is none
+static inline int pool_mask_lowest(const u32 *mask, int words)
+{
+    for (int i = 0; i < words; ++i)
+    {
+        if (mask[i]) return i * 32 + bit_ctz32(mask[i]);
+    }
+
+    return -1;
+}
+
+static inline void pool_mask_set(u32 *mask, int slot, bool free)
+{
+    if (free)
+        mask[slot >> 5] |= 1u << (slot & 31);
+    else
+        mask[slot >> 5] &= ~(1u << (slot & 31));
+}
+
+// position in an active list of the first slot index above id
+static int active_list_after(const u16 *list, int count, int id)
+{
+    int lo = 0;
+    int hi = count;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) >> 1;
+        if ((int)list[mid] <= id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+// lists stay sorted, rather than having the last entry swapped into the
+// hole on removal. slot order is the order entities get updated in, and
+// the lists are short enough that shifting them is cheap.
+static void active_list_insert(u16 *list, int *count, int id)
+{
+    int pos = active_list_after(list, *count, id);
+    for (int i = *count; i > pos; --i)
+        list[i] = list[i-1];
+
+    list[pos] = (u16) id;
+    ++*count;
+}
+
+static bool active_list_remove(u16 *list, int *count, int id)
+{
+    int pos = active_list_after(list, *count, id) - 1;
+    if (pos < 0 || (int)list[pos] != id) return false;
+
+    --*count;
+    for (int i = pos; i < *count; ++i)
+        list[i] = list[i+1];
+
+    return true;
+}
 
 // this is called by both entity_alloc and game_restore_state
 static void on_entity_alloc(entity_s *ent)
 {
+    const int id = ent - g_game.entities;
+    pool_mask_set(ent_free_mask, id, false);
+    pool_mask_set(ent_dirty_mask, id, true);
+    active_list_insert(g_game.active_ents, &g_game.active_ent_count, id);
+
     if (render_object_count == MAX_RENDER_OBJS)
         LOG_ERR("render object pool is full!");
     else
@@ -106,27 +249,26 @@ static void on_entity_alloc(entity_s *ent)
 
 entity_s* entity_alloc(void)
 {
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+    int id = pool_mask_lowest(ent_free_mask, ENTITY_MASK_WORDS);
+    if (id < 0)
     {
-        entity_s *ent = g_game.entities + i;
-        if (ent->flags & ENTITY_FLAG_ENABLED) continue;
-
-        *ent = (entity_s) {
-            .flags = ENTITY_FLAG_ENABLED,
-            .gmult = FIX_ONE,
-            .mass = 2,
-            .actor.face_dir = 1,
-            .col.group = COLGROUP_DEFAULT,
-            .col.mask = COLGROUP_ALL,
-            .sprite.palette = GFX_OBJPAL_MUL
-        };
-
-        on_entity_alloc(ent);
-        return ent;
+        LOG_ERR("entity pool is full!");
+        return NULL;
     }
 
-    LOG_ERR("entity pool is full!");
-    return NULL;
+    entity_s *ent = g_game.entities + id;
+    *ent = (entity_s) {
+        .flags = ENTITY_FLAG_ENABLED,
+        .gmult = FIX_ONE,
+        .mass = 2,
+        .actor.face_dir = 1,
+        .col.group = COLGROUP_DEFAULT,
+        .col.mask = COLGROUP_ALL,
+        .sprite.palette = GFX_OBJPAL_MUL
+    };
+
+    on_entity_alloc(ent);
+    return ent;
 }
 
 void entity_free(entity_s *entity)
@@ -141,6 +283,12 @@ void entity_free(entity_s *entity)
         entity->behavior->free(entity);
 
     entity->flags = 0;
+    entity_update_caps(entity);
+
+    const int id = entity - g_game.entities;
+    pool_mask_set(ent_free_mask, id, true);
+    if (!active_list_remove(g_game.active_ents, &g_game.active_ent_count, id))
+        LOG_ERR("entity_free: entity %i is not in the active list", id);
 
     // remove from render list
     for (int i = 0; i < render_object_count; ++i)
@@ -158,6 +306,94 @@ void entity_free(entity_s *entity)
     LOG_ERR("entity_free: could not find entity in render list");
 }
 
+static uint entity_get_caps(const entity_s *ent)
+{
+    const u32 flags = ent->flags;
+    if (!(flags & ENTITY_FLAG_ENABLED)) return 0;
+
+    uint caps = 0;
+    if ((ent->behavior && ent->behavior->update) ||
+        (flags & (ENTITY_FLAG_ACTOR | ENTITY_FLAG_MOVING | ENTITY_FLAG_DAMPING)))
+        caps |= 1 << ENTITY_CAP_UPDATE;
+
+    if (flags & ENTITY_FLAG_ACTOR)
+        caps |= 1 << ENTITY_CAP_ACTOR;
+    if (flags & ENTITY_FLAG_COLLIDE)
+        caps |= 1 << ENTITY_CAP_COLLIDE;
+    if (ent->sprite.flags & SPRITE_FLAG_PLAYING)
+        caps |= 1 << ENTITY_CAP_ANIMATE;
+
+    return caps;
+}
+
+// global messages the entity is subscribed to, as ENTITY_MSG_BITs
+static u32 entity_get_msg_subs(const entity_s *ent)
+{
+    const u32 flags = ent->flags;
+    if (!(flags & ENTITY_FLAG_ENABLED)) return 0;
+    if (!(flags & ENTITY_FLAG_GLOBAL_MSG)) return 0;
+    if (!ent->behavior || !ent->behavior->message) return 0;
+
+    return ent->behavior->global_msgs;
+}
+
+static void slot_lists_set(u32 (*lists)[ENTITY_MASK_WORDS], int list_count,
+                           int id, u32 member_of)
+{
+    const u32 bit = 1u << (id & 31);
+    for (int i = 0; i < list_count; ++i)
+    {
+        u32 *word = &lists[i][id >> 5];
+        if (member_of & (1u << i))
+            *word |= bit;
+        else
+            *word &= ~bit;
+    }
+}
+
+void entity_update_caps(entity_s *ent)
+{
+    const int id = ent - g_game.entities;
+    slot_lists_set(g_game.ent_caps, ENTITY_CAP_COUNT, id,
+                   entity_get_caps(ent));
+    slot_lists_set(g_game.msg_subs, ENTITY_MSG_COUNT, id,
+                   entity_get_msg_subs(ent));
+}
+
+#ifdef DEVDEBUG
+// catches flag changes that didn't go through entity_update_caps
+static u32 slot_lists_get(u32 (*lists)[ENTITY_MASK_WORDS], int list_count,
+                          int id)
+{
+    u32 member_of = 0;
+    for (int i = 0; i < list_count; ++i)
+    {
+        if (lists[i][id >> 5] & (1u << (id & 31)))
+            member_of |= 1u << i;
+    }
+
+    return member_of;
+}
+
+static void check_entity_caps(void)
+{
+    for (int k = 0; k < g_game.active_ent_count; ++k)
+    {
+        const int id = g_game.active_ents[k];
+        entity_s *ent = g_game.entities + id;
+
+        if (slot_lists_get(g_game.ent_caps, ENTITY_CAP_COUNT, id) !=
+                entity_get_caps(ent) ||
+            slot_lists_get(g_game.msg_subs, ENTITY_MSG_COUNT, id) !=
+                entity_get_msg_subs(ent))
+        {
+            LOG_ERR("entity %i: capability lists are out of date", id);
+            entity_update_caps(ent);
+        }
+    }
+}
+#endif
+
 bool entity_queue_free(entity_s *ent)
 {
     if (ent->flags & ENTITY_FLAG_QFREE) return true;
@@ -172,6 +408,11 @@ bool entity_queue_free(entity_s *ent)
 // this is called by both projectile_alloc and game_restore_state
 static void on_projectile_alloc(projectile_s *proj)
 {
+    const int id = proj - g_game.projectiles;
+    pool_mask_set(proj_free_mask, id, false);
+    pool_mask_set(proj_dirty_mask, id, true);
+    active_list_insert(g_game.active_projs, &g_game.active_proj_count, id);
+
     if (render_object_count == MAX_RENDER_OBJS)
         LOG_ERR("render object pool is full!");
     else
@@ -186,22 +427,22 @@ static void on_projectile_alloc(projectile_s *proj)
 
 projectile_s* projectile_alloc(void)
 {
-    for (int i = 0; i < MAX_PROJECTILE_COUNT; ++i)
+    int id = pool_mask_lowest(proj_free_mask, PROJ_FREE_MASK_WORDS);
+    if (id < 0)
     {
-        projectile_s *proj = g_game.projectiles + i;
-        if (IS_PROJ_ACTIVE(proj)) continue;
-
-        *proj = (projectile_s)
-        {
-            .flags = PROJ_FLAG_ACTIVE,
-        };
-
-        on_projectile_alloc(proj);
-        return proj;
+        LOG_ERR("projectile pool is full!");
+        return NULL;
     }
 
-    LOG_ERR("projectile pool is full!");
-    return NULL;
+    projectile_s *proj = g_game.projectiles + id;
+    *proj = (projectile_s)
+    {
+        .flags = PROJ_FLAG_ACTIVE,
+        .owner = PROJ_OWNER_NONE,
+    };
+
+    on_projectile_alloc(proj);
+    return proj;
 }
 
 void projectile_free(projectile_s *proj)
@@ -212,6 +453,11 @@ void projectile_free(projectile_s *proj)
     game_physics_on_proj_free(proj);
     proj->flags = 0;
 
+    const int id = proj - g_game.projectiles;
+    pool_mask_set(proj_free_mask, id, true);
+    if (!active_list_remove(g_game.active_projs, &g_game.active_proj_count, id))
+        LOG_ERR("projectile_free: projectile %i is not in the active list", id);
+
     // remove from render list
     for (int i = 0; i < render_object_count; ++i)
     {
@@ -246,15 +492,13 @@ static void update_entities(void)
 {
     const FIXED terminal_vel = int2fx(5);
 
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+    for (int id = entity_cap_next(ENTITY_CAP_UPDATE, -1); id >= 0;
+         id = entity_cap_next(ENTITY_CAP_UPDATE, id))
     {
-        entity_s *entity = g_game.entities + i;
-        if (!(entity->flags & ENTITY_FLAG_ENABLED)) continue;
+        entity_s *entity = g_game.entities + id;
 
         if (entity->behavior && entity->behavior->update)
-        {
             entity->behavior->update(entity);
-        }
 
         if (entity->flags & ENTITY_FLAG_ACTOR)
         {
@@ -317,7 +561,10 @@ static void update_entities(void)
             if (entity->vel.x < 0) ++entity->vel.x;
         }
 
-        if (entity->flags & ENTITY_FLAG_MOVING)
+        // sleeping bodies are at rest, so leave them alone until physics
+        // wakes them back up
+        if ((entity->flags & ENTITY_FLAG_MOVING) &&
+            !(entity->flags & ENTITY_FLAG_SLEEPING))
         {
             FIXED g = fxmul(WORLD_GRAVITY, entity->gmult);
             entity->vel.y += g;
@@ -333,12 +580,12 @@ static void update_entities(void)
                 int tx = cx / (WORLD_TILE_SIZE * FIX_ONE);
                 int ty = cy / (WORLD_TILE_SIZE * FIX_ONE);
 
-                if (game_get_col_clamped(tx, ty) == 2)
+                if (game_get_water_bits(tx, ty, 1))
                 {
                     cflags |= COL_FLAG_IN_WATER;
                     int ty2 = (cy - int2fx(1)) / (WORLD_TILE_SIZE * FIX_ONE);
 
-                    if (game_get_col_clamped(tx, ty2) != 2 &&
+                    if (!game_get_water_bits(tx, ty2, 1) &&
                         abs(entity->vel.y) < TO_FIXED(0.125))
                     {
                         entity->vel.y = 0;
@@ -368,15 +615,18 @@ static void update_entities(void)
 
 static void update_projectiles()
 {
-    for (int i = 0; i < MAX_PROJECTILE_COUNT; ++i)
+    // in slot order, same as always. freeing a projectile shifts the rest of
+    // the list down onto it, so k only moves on if it's still there.
+    for (int k = 0; k < g_game.active_proj_count;)
     {
-        projectile_s *proj = g_game.projectiles + i;
-        if (!IS_PROJ_ACTIVE(proj)) continue;
+        projectile_s *proj = g_game.projectiles + g_game.active_projs[k];
 
         proj->vy += proj->g;
 
         if (--proj->life == 0)
             projectile_free(proj);
+        else
+            ++k;
     }
 }
 
@@ -390,11 +640,10 @@ static void update_animation()
     const gfx_frame_s *frame_pool =
         (const gfx_frame_s *)((uintptr_t)gfx_root_header + gfx_root_header->frame_pool);
     
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+    for (int id = entity_cap_next(ENTITY_CAP_ANIMATE, -1); id >= 0;
+         id = entity_cap_next(ENTITY_CAP_ANIMATE, id))
     {
-        entity_s *ent = g_game.entities + i;
-        if (!(ent->flags & ENTITY_FLAG_ENABLED)) continue;
-        if (!(ent->sprite.flags & SPRITE_FLAG_PLAYING)) continue;
+        entity_s *ent = g_game.entities + id;
 
         int sprite_time_accum = ent->sprite.accum;
         int sprite_frame = ent->sprite.frame;
@@ -413,7 +662,7 @@ static void update_animation()
                 if (spr->loop)
                     sprite_frame = 0;
                 else
-                    ent->sprite.flags &= ~SPRITE_FLAG_PLAYING;
+                    entity_set_playing(ent, false);
             }
             else
             {
@@ -516,6 +765,21 @@ static void reset_camera(entity_s *player)
     g_game.cam_y = player->pos.y + cam_data->rel_x;
 }
 
+// keeps the camera from showing anything outside of a map of the given size
+static void clamp_camera(FIXED *cam_x, FIXED *cam_y,
+                         int map_width, int map_height)
+{
+    const FIXED x_min = int2fx(SCREEN_WIDTH / 4);
+    const FIXED y_min = int2fx(SCREEN_HEIGHT / 4);
+    const FIXED x_max = int2fx(map_width * 8 - SCREEN_WIDTH / 4);
+    const FIXED y_max = int2fx(map_height * 8 - SCREEN_HEIGHT / 4);
+
+    if (*cam_x < x_min) *cam_x = x_min;
+    if (*cam_y < y_min) *cam_y = y_min;
+    if (*cam_x > x_max) *cam_x = x_max;
+    if (*cam_y > y_max) *cam_y = y_max;
+}
+
 static void update_camera(entity_s *player)
 {
     game_camera_s *const cam_data = &g_game.cam_data;
@@ -588,11 +852,20 @@ void game_init(void)
     };
 
     last_obj_index = 0;
+    pool_mask_fill(ent_free_mask, ENTITY_MASK_WORDS, MAX_ENTITY_COUNT);
+    pool_mask_fill(proj_free_mask, PROJ_FREE_MASK_WORDS, MAX_PROJECTILE_COUNT);
+
+    // nothing is known about the saved state yet, so the first save has to
+    // copy everything
+    pool_mask_fill(ent_dirty_mask, ENTITY_MASK_WORDS, MAX_ENTITY_COUNT);
+    pool_mask_fill(proj_dirty_mask, PROJ_FREE_MASK_WORDS, MAX_PROJECTILE_COUNT);
     ent_free_queue_count = 0;
     proj_free_queue_count = 0;
     render_object_count = 0;
+    room_prefetch.room = NULL;
 
     game_physics_init();
+    rewind_reset();
 
     entity_s *player = entity_alloc();
     entity_player_init(player);
@@ -643,8 +916,22 @@ void game_update(void)
     entity_s *player = &g_game.entities[0];
     g_game.active_interactable = NULL;
 
+    // holding select steps back through the history instead of running the
+    // frame
+    if (key_is_down(KEY_SELECT) && g_game.input_enabled &&
+        g_game.room_trans.phase == 0)
+    {
+        rewind_step();
+        return;
+    }
+
     if (!game_transition_update(player)) return;
 
+    #ifdef DEVDEBUG
+    check_entity_caps();
+    #endif
+
+    game_query_begin_frame();
     update_entities();
     update_projectiles();
     game_physics_update();
@@ -658,17 +945,9 @@ void game_update(void)
 
     update_camera(player);
 
-    const FIXED x_min = int2fx(SCREEN_WIDTH / 4);
-    const FIXED y_min = int2fx(SCREEN_HEIGHT / 4);
-    const FIXED x_max = int2fx(gfx_ctl.bg[GAME_BG_IDX].map_width * 8
-                               - SCREEN_WIDTH / 4);
-    const FIXED y_max = int2fx(gfx_ctl.bg[GAME_BG_IDX].map_height * 8
-                               - SCREEN_HEIGHT / 4);
-
-    if (g_game.cam_x < x_min) g_game.cam_x = x_min;
-    if (g_game.cam_y < y_min) g_game.cam_y = y_min;
-    if (g_game.cam_x > x_max) g_game.cam_x = x_max;
-    if (g_game.cam_y > y_max) g_game.cam_y = y_max;
+    clamp_camera(&g_game.cam_x, &g_game.cam_y,
+                 gfx_ctl.bg[GAME_BG_IDX].map_width,
+                 gfx_ctl.bg[GAME_BG_IDX].map_height);
 
     for (int i = 0; i < proj_free_queue_count; ++i)
         projectile_free(proj_free_queue[i]);
@@ -677,136 +956,155 @@ void game_update(void)
     for (int i = 0; i < ent_free_queue_count; ++i)
         entity_free(ent_free_queue[i]);
     ent_free_queue_count = 0;
-}
 
-#define READ8(ptr, accum) (accum = *((ptr)++), \
-                           accum)
-#define READ16(ptr, accum) (accum = *((ptr)++), \
-                           accum |= *((ptr)++) << 8, \
-                           accum)
-#define READ32(ptr, accum) (accum = *((ptr)++), \
-                           accum |= *((ptr)++) << 8, \
-                           accum |= *((ptr)++) << 16, \
-                           accum |= *((ptr)++) << 24, \
-                           accum)
+    // the room is only half loaded during transitions
+    if (g_game.room_trans.phase == 0)
+        rewind_capture();
+    else if (g_game.room_trans.phase == 1 &&
+             g_game.room_trans.ticks == ROOM_TRANS_FADE_TICKS - 1)
+        room_transition_prefetch_screen(player);
+}
 
-void game_load_room(const world_room_s *room)
+// starts staging a room's collision and graphics into the buffers the current
+// room isn't using. the collision map is copied right away, and the masks and
+// graphics are done by room_prefetch_step.
+static void room_prefetch_begin(const world_room_s *room)
 {
     const mapc_header_s *map = room->map;
-
-    g_game.room = room;
-    g_game.room_collision = game_room_collision;
-    g_game.room_width = (int) map->width;
-    g_game.room_height = (int) map->height;
+    const int buf = room_buf ^ 1;
 
     const u8 *col_data = mapc_collision_data(map);
     const int col_data_size = mapc_collision_data_size(map);
-    if (CEIL_DIV(col_data_size, 4) > GAME_COLLISION_MAP_SIZE)
+
+    // mapc.py won't build a room that fails these
+    if (col_data_size > GAME_COLLISION_MAP_SIZE)
     {
         LOG_ERR("map collision too large to copy to iwram!");
         DBG_CRASH();
     }
 
-    memcpy32(game_room_collision, col_data, CEIL_DIV(col_data_size, 4));
+    if (CEIL_DIV((int) map->width, 32) * (int) map->height > GAME_COLMASK_SIZE)
+    {
+        LOG_ERR("map too large for collision mask!");
+        DBG_CRASH();
+    }
 
-    g_game.gfx_map = (gfx_map_s)
+    if (map->flags & MAPC_FLAG_LZ77)
     {
-        .width = map->width,
-        .height = map->height,
-        .gfx_format = GFX_MAP_FORMAT_MAPC16,
-        .data = mapc_graphics_data(map),
-    };
+        lz77_decompress(col_data, game_room_collision[buf]);
+        lz77_stream_init(&room_prefetch.gfx_stream, mapc_graphics_data(map),
+                         game_room_gfx[buf]);
+        room_prefetch.gfx_data = game_room_gfx[buf];
+    }
+    else
+    {
+        memcpy32(game_room_collision[buf], col_data,
+                 CEIL_DIV(col_data_size, 4));
+        room_prefetch.gfx_data = mapc_graphics_data(map);
+    }
 
-    u32 accum;
+    room_prefetch.room = room;
+    room_prefetch.rows_built = 0;
+}
 
-    const u8 *data_ptr = mapc_entity_data(map);
-    int ent_count = data_ptr ? READ16(data_ptr, accum) : 0;
-    
-    for (int i = 0; i < ent_count; ++i)
-    {
-        int chunk_size = READ16(data_ptr, accum);
-        const u8 *chunk_ptr = data_ptr;
-        data_ptr += chunk_size;
+// build up to max_rows more rows of the staged room's per-row solid/water
+// bitmasks from the 2-bit collision map, and decompress the same rows of its
+// graphics
+static void room_prefetch_step(int max_rows)
+{
+    if (!room_prefetch.room) return;
 
-        s16 ex = READ16(chunk_ptr, accum);
-        s16 ey = READ16(chunk_ptr, accum);
-        s16 ew = READ16(chunk_ptr, accum);
-        s16 eh = READ16(chunk_ptr, accum);
-        const char *name = (const char *)chunk_ptr;
-        while (*(chunk_ptr++) != 0);
+    const mapc_header_s *map = room_prefetch.room->map;
+    const int buf = room_buf ^ 1;
+    const int w = (int) map->width;
+    const int h = (int) map->height;
+    const int pitch = CEIL_DIV(w, 32);
 
-        int prop_count = READ8(chunk_ptr, accum);
+    const int y0 = room_prefetch.rows_built;
+    const int y1 = (h - y0 > max_rows) ? y0 + max_rows : h;
 
-        // oh. Bruh. i wrote this entire malloc implementation only to then
-        // realize "wait. actually there won't be any more than one property per
-        // object. so like. i can just allocate this on the stack."
-        entity_load_prop_s props[8];
+    for (int y = y0; y < y1; ++y)
+    {
+        u32 *solid_row = game_room_solid_mask[buf] + y * pitch;
+        u32 *water_row = game_room_water_mask[buf] + y * pitch;
 
-        if (prop_count > 8)
+        memset32(solid_row, 0, pitch);
+        memset32(water_row, 0, pitch);
+
+        for (int x = 0; x < w; ++x)
         {
-            LOG_ERR("only up to 8 entity properties supported!");
-            continue;
+            int col = mapc_collision_get(game_room_collision[buf], w, x, y);
+            if (col == 1)
+                solid_row[x >> 5] |= 1u << (x & 31);
+            else if (col == 2)
+                water_row[x >> 5] |= 1u << (x & 31);
         }
+    }
 
-        for (int i = 0; i < prop_count; ++i)
-        {
-            const char *prop_name = (const char *)chunk_ptr;
-            while (*(chunk_ptr++) != 0);
-            entity_load_prop_type_e prop_type = READ8(chunk_ptr, accum);
+    if (map->flags & MAPC_FLAG_LZ77)
+        lz77_stream_run(&room_prefetch.gfx_stream, y1 * w * sizeof(u16));
 
-            props[i].name = prop_name;
-            props[i].type = prop_type;
+    room_prefetch.rows_built = y1;
+}
 
-            switch (prop_type)
-            {
-            case ELPT_STRING:
-            {
-                const char *prop_data_str = (const char *)chunk_ptr;
-                while (*(chunk_ptr++) != 0);
+static gfx_map_s room_gfx_map(const world_room_s *room, const u16 *gfx_data)
+{
+    const mapc_header_s *map = room->map;
 
-                props[i].data = (uintptr_t) prop_data_str;
-                break;
-            }
+    return (gfx_map_s)
+    {
+        .width = map->width,
+        .height = map->height,
+        .gfx_format = GFX_MAP_FORMAT_MAPC16,
+        .data = gfx_data,
+    };
+}
 
-            case ELPT_INT:
-            {
-                int prop_data_int = READ32(chunk_ptr, accum);
-                props[i].data = (uintptr_t) prop_data_int;
-                break;
-            }
+void game_load_room(const world_room_s *room)
+{
+    const mapc_header_s *map = room->map;
 
-            case ELPT_DECIMAL: // fixed-point
-            {
-                FIXED prop_data_fx = READ32(chunk_ptr, accum);
-                props[i].data = (uintptr_t) prop_data_fx;
-                break;
-            }
+    // finish staging the room's collision (or do all of it, if it wasn't
+    // prefetched), then switch over to it
+    if (room_prefetch.room != room)
+        room_prefetch_begin(room);
 
-            default:
-                LOG_ERR("unknown property data type %i", (int) prop_type);
-                break;
-            }
-        }
+    room_prefetch_step(INT_MAX);
+    room_prefetch.room = NULL;
+    room_buf ^= 1;
 
-        entity_load_s load_ent = (entity_load_s)
-        {
-            .x = int2fx((int) ex),
-            .y = int2fx((int) ey),
-            .w = int2fx((int) ew),
-            .h = int2fx((int) eh),
-            .name = name,
-            .prop_count = prop_count,
-            .props = props,
-        };
+    const u16 *gfx_data = room_prefetch.gfx_data;
+
+    g_game.room = room;
+    g_game.room_collision = game_room_collision[room_buf];
+    g_game.room_solid_mask = game_room_solid_mask[room_buf];
+    g_game.room_water_mask = game_room_water_mask[room_buf];
+    g_game.room_colmask_pitch = CEIL_DIV((int) map->width, 32);
+    g_game.room_width = (int) map->width;
+    g_game.room_height = (int) map->height;
+
+    game_physics_on_room_load();
+
+    // the history is of the old room's entities
+    rewind_reset();
+
+    g_game.gfx_map = room_gfx_map(room, gfx_data);
 
-        if (!strcmp(load_ent.name, "player"))
+    const mapc_ent_data_s *ent_data = mapc_entity_data(map);
+    const int ent_count = ent_data ? ent_data->count : 0;
+
+    for (int i = 0; i < ent_count; ++i)
+    {
+        const mapc_spawn_s *spawn = ent_data->spawns + i;
+
+        if (spawn->type == MAPC_ENT_PLAYER)
         {
-            g_game.room_player_x = load_ent.x;
-            g_game.room_player_y = load_ent.y;
+            g_game.room_player_x = int2fx((int) spawn->x);
+            g_game.room_player_y = int2fx((int) spawn->y);
         }
         else
         {
-            game_load_entity(&load_ent);
+            game_load_entity(spawn);
         }
     }
 
@@ -818,15 +1116,15 @@ void game_load_room(const world_room_s *room)
     }
 }
 
-void game_send_global_message(const char *id, void *data)
+void game_send_global_message(entity_msg_e id, void *data)
 {
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+    // only entities whose behavior has a message handler are subscribed
+    const u32 *subs = g_game.msg_subs[id];
+    for (int i = entity_mask_next(subs, -1); i >= 0;
+         i = entity_mask_next(subs, i))
     {
         entity_s *ent = g_game.entities + i;
-        if (!(ent->flags & ENTITY_FLAG_GLOBAL_MSG)) continue;
-
-        if (ent->behavior && ent->behavior->message)
-            ent->behavior->message(ent, id, data);
+        ent->behavior->message(ent, id, data);
     }
 }
 
@@ -1082,24 +1380,19 @@ static void change_room(const world_room_s *new_room)
     }
 
     // remove all entities in the world, except ones with the
-    // keep-on-room-change flag (i.e. the player and the platform cursor)
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+    // keep-on-room-change flag (i.e. the player and the platform cursor).
+    // backwards, since freeing an entity removes it from the active list.
+    for (int k = g_game.active_ent_count - 1; k >= 0; --k)
     {
-        entity_s *ent = &g_game.entities[i];
-
-        if (!(ent->flags & ENTITY_FLAG_ENABLED)) continue;
+        entity_s *ent = g_game.entities + g_game.active_ents[k];
         if (ent->flags & ENTITY_FLAG_KEEP_ON_ROOM_CHANGE) continue;
 
         entity_free(ent);
     }
 
     // remove all projectiles
-    for (int i = 0; i < MAX_PROJECTILE_COUNT; ++i)
-    {
-        projectile_s *proj = &g_game.projectiles[i];
-        if (!IS_PROJ_ACTIVE(proj)) continue;
-        projectile_free(proj);
-    }
+    for (int k = g_game.active_proj_count - 1; k >= 0; --k)
+        projectile_free(g_game.projectiles + g_game.active_projs[k]);
 
     game_load_room(new_room);
     gfx_load_map(GAME_BG_IDX, &g_game.gfx_map);
@@ -1188,6 +1481,72 @@ static void room_transition_inactive_update(entity_s *player)
         .override_player_move_x = true,
         .player_move_x = player_mx
     };
+
+    room_prefetch_begin(new_room);
+}
+
+// where the player's collision box ends up in the new room, once the room
+// transition is done
+static void room_transition_entry_pos(const entity_s *player,
+                                      FIXED *out_x, FIXED *out_y)
+{
+    const world_room_s *old_room = g_game.room;
+    const world_room_s *new_room = g_game.room_trans.new_room;
+
+    FIXED colw = int2fx((int) player->col.w);
+    FIXED colh = int2fx((int) player->col.h);
+    FIXED cx = player->pos.x + colw / 2;
+    FIXED cy = player->pos.y + colh / 2;
+
+    switch (g_game.room_trans.dir)
+    {
+    case DIR4_RIGHT:
+        cx = 0;
+        cy += int2fx((old_room->y - new_room->y) * WORLD_MATRIX_GRID_HEIGHT * WORLD_TILE_SIZE);
+        break;
+
+    case DIR4_LEFT:
+        cx = int2fx(new_room->map->width * WORLD_TILE_SIZE);
+        cy += int2fx((old_room->y - new_room->y) * WORLD_MATRIX_GRID_HEIGHT * WORLD_TILE_SIZE);
+        break;
+
+    case DIR4_DOWN:
+        cx += int2fx((old_room->x - new_room->x) * WORLD_MATRIX_GRID_WIDTH * WORLD_TILE_SIZE);
+        cy = 0;
+        break;
+
+    case DIR4_UP:
+        cx += int2fx((old_room->x - new_room->x) * WORLD_MATRIX_GRID_WIDTH * WORLD_TILE_SIZE);
+        cy = int2fx(new_room->map->height * WORLD_TILE_SIZE);
+        break;
+
+    default: LOG_ERR("unreachable switch statement wtf???");
+    }
+
+    *out_x = cx - colw / 2;
+    *out_y = cy - colh / 2;
+}
+
+// on the last frame of the fade out the player won't move anymore, so the
+// new room's first screen can be drawn ahead of time
+static void room_transition_prefetch_screen(const entity_s *player)
+{
+    const world_room_s *new_room = g_game.room_trans.new_room;
+
+    FIXED cam_x, cam_y;
+    room_transition_entry_pos(player, &cam_x, &cam_y);
+    clamp_camera(&cam_x, &cam_y, new_room->map->width, new_room->map->height);
+
+    // the screen can be anywhere in the room, so all of its graphics have to
+    // be there already
+    if (room_prefetch.room != new_room)
+        room_prefetch_begin(new_room);
+    room_prefetch_step(INT_MAX);
+
+    const gfx_map_s map = room_gfx_map(new_room, room_prefetch.gfx_data);
+    gfx_prefetch_map(GAME_BG_IDX, &map,
+                     fx2int(cam_x) * 2 - SCREEN_WIDTH / 2,
+                     fx2int(cam_y) * 2 - SCREEN_HEIGHT / 2);
 }
 
 static bool room_transition_phase1_update(entity_s *player)
@@ -1195,51 +1554,44 @@ static bool room_transition_phase1_update(entity_s *player)
     if (g_game.room_trans.dir == DIR4_UP)
         player->vel.y = TO_FIXED(-1);
 
-    if (++g_game.room_trans.ticks < 30)
+    if (++g_game.room_trans.ticks < ROOM_TRANS_FADE_TICKS)
     {
         FIXED fac = g_game.room_trans.ticks * (FIX_ONE / 20);
         gfx_ctl.palette_mul = FIX_ONE - fac;
+        room_prefetch_step(ROOM_PREFETCH_ROWS_PER_FRAME);
         return true;
     }
 
-    const world_room_s *old_room = g_game.room;
-    const world_room_s *new_room = g_game.room_trans.new_room;
-    change_room(new_room);
+    // the position has to be worked out from the old room
+    FIXED entry_x, entry_y;
+    room_transition_entry_pos(player, &entry_x, &entry_y);
 
-    FIXED colw = int2fx((int) player->col.w);
-    FIXED colh = int2fx((int) player->col.h);
-    FIXED cx = player->pos.x + colw / 2;
-    FIXED cy = player->pos.y + colh / 2;
+    change_room(g_game.room_trans.new_room);
+
+    player->pos.x = entry_x;
+    player->pos.y = entry_y;
 
     int player_mx = 0;
 
     switch (g_game.room_trans.dir)
     {
     case DIR4_RIGHT:
-        cx = 0;
-        cy += int2fx((old_room->y - new_room->y) * WORLD_MATRIX_GRID_HEIGHT * WORLD_TILE_SIZE);
         player->vel.y = 0;
         player_mx = 1;
         break;
 
     case DIR4_LEFT:
-        cx = int2fx(new_room->map->width * WORLD_TILE_SIZE);
-        cy += int2fx((old_room->y - new_room->y) * WORLD_MATRIX_GRID_HEIGHT * WORLD_TILE_SIZE);
         player->vel.y = 0;
         player_mx = -1;
         break;
 
     case DIR4_DOWN:
-        cx += int2fx((old_room->x - new_room->x) * WORLD_MATRIX_GRID_WIDTH * WORLD_TILE_SIZE);
-        cy = 0;
         player->vel.x = 0;
         player->vel.y = TO_FIXED(1);
         player_mx = 0;
         break;
 
     case DIR4_UP:
-        cx += int2fx((old_room->x - new_room->x) * WORLD_MATRIX_GRID_WIDTH * WORLD_TILE_SIZE);
-        cy = int2fx(new_room->map->height * WORLD_TILE_SIZE);
         player->vel.x = 0;
         player->vel.y = TO_FIXED(-2);
         player_mx = player->actor.face_dir;
@@ -1248,9 +1600,6 @@ static bool room_transition_phase1_update(entity_s *player)
     default: LOG_ERR("unreachable switch statement wtf???");
     }
 
-    player->pos.x = cx - colw / 2;
-    player->pos.y = cy - colh / 2;
-
     g_game.room_trans = (room_trans_state_s)
     {
         .phase = 2,
@@ -1262,17 +1611,9 @@ static bool room_transition_phase1_update(entity_s *player)
     g_game.cam_x = player->pos.x;
     g_game.cam_y = player->pos.y;
 
-    const FIXED x_min = int2fx(SCREEN_WIDTH / 4);
-    const FIXED y_min = int2fx(SCREEN_HEIGHT / 4);
-    const FIXED x_max = int2fx(gfx_ctl.bg[GAME_BG_IDX].map_width * 8
-                               - SCREEN_WIDTH / 4);
-    const FIXED y_max = int2fx(gfx_ctl.bg[GAME_BG_IDX].map_height * 8
-                               - SCREEN_HEIGHT / 4);
-
-    if (g_game.cam_x < x_min) g_game.cam_x = x_min;
-    if (g_game.cam_y < y_min) g_game.cam_y = y_min;
-    if (g_game.cam_x > x_max) g_game.cam_x = x_max;
-    if (g_game.cam_y > y_max) g_game.cam_y = y_max;
+    clamp_camera(&g_game.cam_x, &g_game.cam_y,
+                 gfx_ctl.bg[GAME_BG_IDX].map_width,
+                 gfx_ctl.bg[GAME_BG_IDX].map_height);
 
     g_game.active_water_tank = NULL;
 
@@ -1317,31 +1658,29 @@ static bool game_transition_update(entity_s *player)
     return true;
 }
 
-void game_save_state(void)
+static void active_list_to_mask(u32 *mask, int words, const u16 *list,
+                                int count)
 {
-    // copy entity data
-    const entity_s *src_ent = g_game.entities;
-    entity_s *dst_ent = game_saved_state.entities;
+    for (int i = 0; i < words; ++i)
+        mask[i] = 0;
 
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
-    {
-        *dst_ent = *src_ent;
-        ++dst_ent;
-        ++src_ent;
-    }
-
-    // copy projectile data
-    const projectile_s *src_proj = g_game.projectiles;
-    projectile_s *dst_proj = game_saved_state.projectiles;
+    for (int k = 0; k < count; ++k)
+        pool_mask_set(mask, list[k], true);
+}
 
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
-    {
-        *dst_proj = *src_proj;
-        ++dst_proj;
-        ++src_proj;
-    }
+// the live and saved state are the same now, so only the slots in use can
+// change from here on
+static void reset_dirty_masks(void)
+{
+    active_list_to_mask(ent_dirty_mask, ENTITY_MASK_WORDS,
+                        g_game.active_ents, g_game.active_ent_count);
+    active_list_to_mask(proj_dirty_mask, PROJ_FREE_MASK_WORDS,
+                        g_game.active_projs, g_game.active_proj_count);
+}
 
-    #define SAVE_PROP(prop) game_saved_state.prop = g_game.prop
+static void get_state_props(game_state_props_s *props)
+{
+    #define SAVE_PROP(prop) props->prop = g_game.prop
     SAVE_PROP(cam_x);
     SAVE_PROP(cam_y);
     SAVE_PROP(room_trans);
@@ -1355,71 +1694,272 @@ void game_save_state(void)
     #undef SAVE_PROP
 }
 
-void game_restore_state(void)
+static void set_state_props(const game_state_props_s *props)
 {
-    // copy entity data, properly freeing newly unallocated slots
-    const entity_s *src_ent = game_saved_state.entities;
-    entity_s *dst_ent = g_game.entities;
+    #define RESTORE_PROP(prop) g_game.prop = props->prop
+    RESTORE_PROP(cam_x);
+    RESTORE_PROP(cam_y);
+    RESTORE_PROP(room_trans);
+    RESTORE_PROP(active_water_tank);
+    RESTORE_PROP(player_ammo);
+    RESTORE_PROP(player_spit_mode);
+    RESTORE_PROP(did_collect_orb);
+    RESTORE_PROP(collected_rorbs);
+    RESTORE_PROP(collected_borbs);
+    RESTORE_PROP(cam_data);
+    #undef RESTORE_PROP
+}
 
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+// copies the given slots of src into the live state, properly freeing and
+// allocating slots whose state changes. freeing and allocating changes the
+// dirty masks, so don't pass those in directly.
+static void apply_state(const game_state_s *src, const u32 *ent_slots,
+                        const u32 *proj_slots)
+{
+    for (int w = 0; w < ENTITY_MASK_WORDS; ++w)
     {
-        if (!ENTITY_ENABLED(src_ent) && ENTITY_ENABLED(dst_ent))
+        for (u32 bits = ent_slots[w]; bits; bits &= bits - 1)
         {
-            entity_free(dst_ent);
+            const int i = (w << 5) + bit_ctz32(bits);
+            const entity_s *src_ent = src->entities + i;
+            entity_s *dst_ent = g_game.entities + i;
+
+            if (!ENTITY_ENABLED(src_ent) && ENTITY_ENABLED(dst_ent))
+            {
+                entity_free(dst_ent);
+            }
+            else
+            {
+                bool need_alloc = !ENTITY_ENABLED(dst_ent) &&
+                                  ENTITY_ENABLED(src_ent);
+                *dst_ent = *src_ent;
+                if (need_alloc) on_entity_alloc(dst_ent);
+
+                // physics doesn't keep track of what was asleep when the
+                // state was saved, so everything starts out awake again
+                dst_ent->flags &= ~ENTITY_FLAG_SLEEPING;
+                entity_update_caps(dst_ent);
+            }
         }
-        else
+    }
+
+    for (int w = 0; w < PROJ_FREE_MASK_WORDS; ++w)
+    {
+        for (u32 bits = proj_slots[w]; bits; bits &= bits - 1)
         {
-            bool need_alloc = !ENTITY_ENABLED(dst_ent) &&
-                              ENTITY_ENABLED(src_ent);
-            *dst_ent = *src_ent;
-            if (need_alloc) on_entity_alloc(dst_ent);
-        }
+            const int i = (w << 5) + bit_ctz32(bits);
+            const projectile_s *src_proj = src->projectiles + i;
+            projectile_s *dst_proj = g_game.projectiles + i;
 
-        ++dst_ent;
-        ++src_ent;
+            if (!IS_PROJ_ACTIVE(src_proj) && IS_PROJ_ACTIVE(dst_proj))
+            {
+                projectile_free(dst_proj);
+            }
+            else
+            {
+                bool need_alloc = !IS_PROJ_ACTIVE(dst_proj) &&
+                                  IS_PROJ_ACTIVE(src_proj);
+                *dst_proj = *src_proj;
+                if (need_alloc) on_projectile_alloc(dst_proj);
+            }
+        }
     }
 
-    // copy projectile data, properly freeing newly unallocated slots
-    const projectile_s *src_proj = game_saved_state.projectiles;
-    projectile_s *dst_proj = g_game.projectiles;
+    // changing rooms clears the rewind history and saves the state anew, so
+    // the room is always the same here. only a camera jump needs a redraw.
+    const bool cam_moved = g_game.cam_x != src->props.cam_x ||
+                           g_game.cam_y != src->props.cam_y;
+
+    set_state_props(&src->props);
+    g_game.player_is_dead = false;
 
-    for (int i = 0; i < MAX_PROJECTILE_COUNT; ++i)
+    if (cam_moved)
+        gfx_mark_scroll_dirty(GAME_BG_IDX);
+}
+
+void game_save_state(void)
+{
+    // copy entity data
+    for (int w = 0; w < ENTITY_MASK_WORDS; ++w)
     {
-        if (!IS_PROJ_ACTIVE(src_proj) && IS_PROJ_ACTIVE(dst_proj))
+        for (u32 bits = ent_dirty_mask[w]; bits; bits &= bits - 1)
         {
-            projectile_free(dst_proj);
+            const int i = (w << 5) + bit_ctz32(bits);
+            game_saved_state.entities[i] = g_game.entities[i];
         }
-        else
+    }
+
+    // copy projectile data
+    for (int w = 0; w < PROJ_FREE_MASK_WORDS; ++w)
+    {
+        for (u32 bits = proj_dirty_mask[w]; bits; bits &= bits - 1)
+        {
+            const int i = (w << 5) + bit_ctz32(bits);
+            game_saved_state.projectiles[i] = g_game.projectiles[i];
+        }
+    }
+
+    get_state_props(&game_saved_state.props);
+    reset_dirty_masks();
+}
+
+void game_restore_state(void)
+{
+    u32 ent_dirty[ENTITY_MASK_WORDS];
+    u32 proj_dirty[PROJ_FREE_MASK_WORDS];
+    memcpy(ent_dirty, ent_dirty_mask, sizeof(ent_dirty));
+    memcpy(proj_dirty, proj_dirty_mask, sizeof(proj_dirty));
+
+    apply_state(&game_saved_state, ent_dirty, proj_dirty);
+    reset_dirty_masks();
+}
+
+// each word of the diffed state is addressed by a 16-bit offset
+_Static_assert(sizeof(entity_s) % 4 == 0 && sizeof(projectile_s) % 4 == 0 &&
+               sizeof(game_state_props_s) % 4 == 0,
+               "rewound state must be made of whole words");
+_Static_assert(sizeof(game_state_s) / 4 < REWIND_MAX_IMAGE_WORDS,
+               "game state too large to rewind");
+
+// the state as of the last captured frame, diffed against the live state
+// each frame
+EWRAM_BSS static game_state_s rewind_image;
+static bool rewind_has_image;
+
+// slots that were in use at the last capture. a slot that was free then and
+// is still free now doesn't matter, so only the others get diffed.
+static u32 rewind_ent_slots[ENTITY_MASK_WORDS];
+static u32 rewind_proj_slots[PROJ_FREE_MASK_WORDS];
+
+static void rewind_reset(void)
+{
+    game_rewind_clear();
+    rewind_has_image = false;
+}
+
+static void rewind_capture_slots(void *image_items, const void *live_items,
+                                 uint item_size, u32 *slots, const u32 *used,
+                                 int words)
+{
+    u32 *image = (u32 *) &rewind_image;
+    const uint item_words = item_size / 4;
+    const uint base = (u32 *) image_items - image;
+
+    for (int w = 0; w < words; ++w)
+    {
+        for (u32 bits = slots[w] | used[w]; bits; bits &= bits - 1)
         {
-            bool need_alloc = !IS_PROJ_ACTIVE(dst_proj) &&
-                              IS_PROJ_ACTIVE(src_proj);
-            *dst_proj = *src_proj;
-            if (need_alloc) on_projectile_alloc(dst_proj);
+            const uint i = (w << 5) + bit_ctz32(bits);
+            game_rewind_put(image, base + i * item_words,
+                            (const u32 *) live_items + i * item_words,
+                            item_words);
         }
 
-        ++dst_proj;
-        ++src_proj;
+        slots[w] = used[w];
     }
+}
 
-    #define RESTORE_PROP(prop) g_game.prop = game_saved_state.prop
-    RESTORE_PROP(cam_x);
-    RESTORE_PROP(cam_y);
-    RESTORE_PROP(room_trans);
-    RESTORE_PROP(active_water_tank);
-    RESTORE_PROP(player_ammo);
-    RESTORE_PROP(player_spit_mode);
-    RESTORE_PROP(did_collect_orb);
-    RESTORE_PROP(collected_rorbs);
-    RESTORE_PROP(collected_borbs);
-    RESTORE_PROP(cam_data);
-    #undef RESTORE_PROP
-    g_game.player_is_dead = false;
+static void rewind_capture(void)
+{
+    u32 ent_used[ENTITY_MASK_WORDS];
+    u32 proj_used[PROJ_FREE_MASK_WORDS];
+    active_list_to_mask(ent_used, ENTITY_MASK_WORDS,
+                        g_game.active_ents, g_game.active_ent_count);
+    active_list_to_mask(proj_used, PROJ_FREE_MASK_WORDS,
+                        g_game.active_projs, g_game.active_proj_count);
+
+    // padding would show up as changes otherwise
+    game_state_props_s props;
+    memset(&props, 0, sizeof(props));
+    get_state_props(&props);
+
+    if (!rewind_has_image)
+    {
+        // there's nothing to diff against yet, so this frame is where the
+        // history starts
+        memcpy(rewind_image.entities, g_game.entities,
+               sizeof(rewind_image.entities));
+        memcpy(rewind_image.projectiles, g_game.projectiles,
+               sizeof(rewind_image.projectiles));
+        rewind_image.props = props;
+
+        memcpy(rewind_ent_slots, ent_used, sizeof(ent_used));
+        memcpy(rewind_proj_slots, proj_used, sizeof(proj_used));
+        rewind_has_image = true;
+        return;
+    }
+
+    // frames where nothing changed still get a record, so that each step
+    // back is one frame
+    game_rewind_begin();
 
-    gfx_mark_scroll_dirty(GAME_BG_IDX);
+    rewind_capture_slots(rewind_image.entities, g_game.entities,
+                         sizeof(entity_s), rewind_ent_slots, ent_used,
+                         ENTITY_MASK_WORDS);
+    rewind_capture_slots(rewind_image.projectiles, g_game.projectiles,
+                         sizeof(projectile_s), rewind_proj_slots, proj_used,
+                         PROJ_FREE_MASK_WORDS);
+
+    const uint props_ofs = offsetof(game_state_s, props) / 4;
+    game_rewind_put((u32 *) &rewind_image, props_ofs, (const u32 *) &props,
+                    sizeof(props) / 4);
+
+    game_rewind_end();
+}
+
+// goes back one captured frame. does nothing once the history runs out.
+static void rewind_step(void)
+{
+    if (!rewind_has_image || !game_rewind_pop((u32 *) &rewind_image))
+        return;
+
+    // the image can have anything in any slot, so look at all of them
+    u32 ent_all[ENTITY_MASK_WORDS];
+    u32 proj_all[PROJ_FREE_MASK_WORDS];
+    pool_mask_fill(ent_all, ENTITY_MASK_WORDS, MAX_ENTITY_COUNT);
+    pool_mask_fill(proj_all, PROJ_FREE_MASK_WORDS, MAX_PROJECTILE_COUNT);
+    apply_state(&rewind_image, ent_all, proj_all);
+
+    active_list_to_mask(rewind_ent_slots, ENTITY_MASK_WORDS,
+                        g_game.active_ents, g_game.active_ent_count);
+    active_list_to_mask(rewind_proj_slots, PROJ_FREE_MASK_WORDS,
+                        g_game.active_projs, g_game.active_proj_count);
 }
 
 void game_start_dialogue(const char *dialogue)
 {
     g_game.queue_dialogue_start = true;
     g_game.dialogue_page = dialogue;
-}
\ No newline at end of file
+}
+
+#ifdef PLATFORM_PC
+const savestate_region_s game_savestate_regions[] = {
+    SAVESTATE_REGION(g_game),
+    SAVESTATE_REGION(game_saved_state),
+    SAVESTATE_REGION(game_room_collision),
+    SAVESTATE_REGION(game_room_solid_mask),
+    SAVESTATE_REGION(game_room_water_mask),
+    SAVESTATE_REGION(game_room_gfx),
+    SAVESTATE_REGION(room_buf),
+    SAVESTATE_REGION(room_prefetch),
+    SAVESTATE_REGION(render_object_count),
+    SAVESTATE_REGION(render_objects),
+    SAVESTATE_REGION(ent_free_mask),
+    SAVESTATE_REGION(proj_free_mask),
+    SAVESTATE_REGION(ent_dirty_mask),
+    SAVESTATE_REGION(proj_dirty_mask),
+    SAVESTATE_REGION(ent_free_queue_count),
+    SAVESTATE_REGION(ent_free_queue),
+    SAVESTATE_REGION(proj_free_queue_count),
+    SAVESTATE_REGION(proj_free_queue),
+    SAVESTATE_REGION(last_obj_index),
+    SAVESTATE_REGION(game_dialogue_buffer),
+    SAVESTATE_REGION(rainbow_shift),
+    SAVESTATE_REGION(rainbow_shift_time_accum),
+    SAVESTATE_REGION(rewind_image),
+    SAVESTATE_REGION(rewind_has_image),
+    SAVESTATE_REGION(rewind_ent_slots),
+    SAVESTATE_REGION(rewind_proj_slots),
+    SAVESTATE_END
+};
+#endif
@@ -8,6 +8,7 @@
 
 #include "gfx.h"
 #include "mapc.h"
+#include "math_util.h"
 
 #define WORLD_SUBPX_SHIFT 4
 #define WORLD_SUBPX_SCALE 16
@@ -28,6 +29,7 @@
 #define ENTITY_FLAG_KEEP_ON_ROOM_CHANGE  (1 << 6)
 #define ENTITY_FLAG_GLOBAL_MSG           (1 << 7) // listens to global msgs
 #define ENTITY_FLAG_QFREE                (1 << 8) // is put in free queue?
+#define ENTITY_FLAG_SLEEPING             (1 << 9) // set by physics when at rest
 
 #define ACTOR_FLAG_GROUNDED   (1 << 0)
 #define ACTOR_FLAG_WALL       (1 << 1)
@@ -52,9 +54,14 @@
 #define COLGROUP_PROJECTILE        (1 << 3)
 #define COLGROUP_ALL               UINT16_MAX
 
+// can be overridden at build time (ENTITY_CAPACITY in the makefiles). the
+// game itself never needs more than 32, but bigger pools are useful for
+// stress-testing.
+#ifndef MAX_ENTITY_COUNT
 #define MAX_ENTITY_COUNT 32
+#endif
 #define MAX_PROJECTILE_COUNT 64
-#define MAX_CONTACT_COUNT 64
+#define MAX_CONTACT_COUNT (MAX_ENTITY_COUNT * 2)
 
 #define PLAYER_DROPLET_TYPE_SIDE      0
 #define PLAYER_DROPLET_TYPE_SIDE_SLOW 1
@@ -63,6 +70,8 @@
 #define PROJ_FLAG_ACTIVE 1
 #define PROJ_FLAG_QFREE  2 // if projectile is put in free queue
 
+#define PROJ_OWNER_NONE 0xFFFF
+
 #define GUN_ENEMY_DIRFLAG_L   1
 #define GUN_ENEMY_DIRFLAG_TL  2
 #define GUN_ENEMY_DIRFLAG_T   4
@@ -79,6 +88,22 @@
 #define GAME_MAX_RORBS      5
 #define GAME_MAX_BORBS      4
 
+// one bit per entity slot
+#define ENTITY_MASK_WORDS CEIL_DIV(MAX_ENTITY_COUNT, 32)
+
+// the per-frame passes an entity can take part in. each one has a bitmask of
+// member slots in g_game.ent_caps, so a pass only visits its members.
+typedef enum entity_cap
+{
+    ENTITY_CAP_UPDATE,     // has behavior->update, or is an actor, moving or
+                           // damping
+    ENTITY_CAP_ACTOR,      // ENTITY_FLAG_ACTOR
+    ENTITY_CAP_COLLIDE,    // ENTITY_FLAG_COLLIDE
+    ENTITY_CAP_ANIMATE,    // SPRITE_FLAG_PLAYING
+
+    ENTITY_CAP_COUNT
+} entity_cap_e;
+
 typedef enum dir4
 {
     DIR4_RIGHT,
@@ -87,11 +112,17 @@ typedef enum dir4
     DIR4_DOWN
 } dir4_e;
 
-// typedef enum entity_msgid
-// {
-//     ENTITY_MSG_INTERACT,
-//     ENTITY_MSG_ATTACKED
-// } entity_msgid_e;
+// ids for behavior_def_s::message. a behavior can also receive them from
+// game_send_global_message by listing them in global_msgs.
+typedef enum entity_msg
+{
+    ENTITY_MSG_BROKE_STALACTITE,
+    ENTITY_MSG_STALACTITE_ATTACK,
+
+    ENTITY_MSG_COUNT
+} entity_msg_e;
+
+#define ENTITY_MSG_BIT(id) (1u << (id))
 
 typedef enum proj_kind
 {
@@ -116,6 +147,7 @@ typedef struct projectile
     bool did_touch_this_frame;
 
     u16 life;
+    u16 owner; // slot of the entity that fired it, or PROJ_OWNER_NONE
 
     FIXED px, py;
     FIXED vx, vy;
@@ -140,7 +172,11 @@ typedef struct behavior_def
 
     // generic message. returns true if the message was recognized and should be
     // sinked ("sink" behavior is context-dependent).
-    bool (*message)(struct entity *self, const char *id, void *data);
+    bool (*message)(struct entity *self, entity_msg_e id, void *data);
+
+    // global messages that entities with ENTITY_FLAG_GLOBAL_MSG get sent,
+    // as ENTITY_MSG_BITs
+    u32 global_msgs;
 } behavior_def_s;
 
 typedef struct entity
@@ -211,8 +247,27 @@ typedef struct game {
     entity_s entities[MAX_ENTITY_COUNT];
     projectile_s projectiles[MAX_PROJECTILE_COUNT];
 
+    // slot indices of the enabled entities and active projectiles, in
+    // ascending order. per-frame passes walk these rather than the pools.
+    int active_ent_count;
+    int active_proj_count;
+    u16 active_ents[MAX_ENTITY_COUNT];
+    u16 active_projs[MAX_PROJECTILE_COUNT];
+
+    // members of each entity_cap_e, and the subscribers of each global
+    // message. see entity_update_caps.
+    u32 ent_caps[ENTITY_CAP_COUNT][ENTITY_MASK_WORDS];
+    u32 msg_subs[ENTITY_MSG_COUNT][ENTITY_MASK_WORDS];
+
     const world_room_s *room;
     const u8 *room_collision;
+
+    // per-row bitmask index of room_collision. bit (x & 31) of word
+    // [y * room_colmask_pitch + (x >> 5)] is set if tile (x, y) is solid or
+    // water, respectively.
+    const u32 *room_solid_mask;
+    const u32 *room_water_mask;
+    int room_colmask_pitch; // in words
     gfx_map_s gfx_map;
     int room_width;
     int room_height;
@@ -256,31 +311,6 @@ typedef struct game {
     bool did_jingle_finish;
 } game_s;
 
-typedef enum entity_load_prop_type
-{
-    ELPT_STRING,
-    ELPT_INT,
-    ELPT_DECIMAL,
-} entity_load_prop_type_e;
-
-typedef struct entity_load_prop
-{
-    const char *name;
-    int type;
-    uintptr_t data;
-} entity_load_prop_s;
-
-typedef struct entity_load
-{
-    const char *name;
-    FIXED x;
-    FIXED y;
-    FIXED w;
-    FIXED h;
-    uint prop_count;
-    entity_load_prop_s *props;
-} entity_load_s;
-
 extern game_s g_game;
 
 entity_s* entity_alloc(void);
@@ -290,6 +320,66 @@ void entity_free(entity_s *entity);
 // returns false if queue is full.
 bool entity_queue_free(entity_s *proj);
 
+// updates which capability and message lists the entity is in. this needs to
+// be called after changing the ACTOR, COLLIDE, GLOBAL_MSG, MOVING or DAMPING
+// flags, the behavior, or SPRITE_FLAG_PLAYING. the helpers below do it for you.
+void entity_update_caps(entity_s *ent);
+
+static inline void entity_set_flags(entity_s *ent, u32 flags)
+{
+    ent->flags |= flags;
+    entity_update_caps(ent);
+}
+
+static inline void entity_clear_flags(entity_s *ent, u32 flags)
+{
+    ent->flags &= ~flags;
+    entity_update_caps(ent);
+}
+
+static inline void entity_set_behavior(entity_s *ent,
+                                       const behavior_def_s *behavior)
+{
+    ent->behavior = behavior;
+    entity_update_caps(ent);
+}
+
+static inline void entity_set_playing(entity_s *ent, bool playing)
+{
+    if (playing)
+        ent->sprite.flags |= SPRITE_FLAG_PLAYING;
+    else
+        ent->sprite.flags &= ~SPRITE_FLAG_PLAYING;
+
+    entity_update_caps(ent);
+}
+
+// returns the next slot after id whose bit is set in the mask, or -1 if
+// there isn't one. start with id = -1. the mask is read as it is at each
+// step, so entities added or removed during the walk are handled the same way
+// a plain loop over the slots would handle them.
+static inline int entity_mask_next(const u32 *mask, int id)
+{
+    ++id;
+
+    int w = id >> 5;
+    if (w >= ENTITY_MASK_WORDS) return -1;
+
+    u32 bits = mask[w] & (UINT32_MAX << (id & 31));
+    while (!bits)
+    {
+        if (++w == ENTITY_MASK_WORDS) return -1;
+        bits = mask[w];
+    }
+
+    return (w << 5) + bit_ctz32(bits);
+}
+
+static inline int entity_cap_next(entity_cap_e cap, int id)
+{
+    return entity_mask_next(g_game.ent_caps[cap], id);
+}
+
 projectile_s* projectile_alloc(void);
 void projectile_free(projectile_s *proj);
 
@@ -302,7 +392,10 @@ void game_deinit(void);
 void game_update(void);
 void game_load_room(const world_room_s *room);
 void game_reset_player_pos(void);
-void game_send_global_message(const char *id, void *data);
+
+// sends the message to every entity subscribed to it, in slot order
+void game_send_global_message(entity_msg_e id, void *data);
+
 void game_render(void);
 void game_save_state(void);
 void game_restore_state(void);
@@ -312,7 +405,7 @@ void game_play_jingle(int module_idx);
 // buffer for dynamic construction of dialogue
 EWRAM_BSS extern char game_dialogue_buffer[DIALOGUE_BUFFER_SIZE];
 
-void game_load_entity(const entity_load_s *load_data);
+void game_load_entity(const mapc_spawn_s *spawn);
 
 static inline int game_get_col(int tx, int ty)
 {
@@ -334,6 +427,61 @@ static inline int game_get_col_clamped(int tx, int ty)
     return mapc_collision_get(g_game.room_collision, g_game.room_width, tx, ty);
 }
 
+// get a bitmask of n (1-32) consecutive tiles in a row of a collision mask,
+// starting at (tx, ty). bit i corresponds to tile (tx + i, ty). out-of-bounds
+// tiles are clamped to the room edges, same as game_get_col_clamped.
+static inline u32 game_colmask_get_bits(const u32 *mask, int tx, int ty, int n)
+{
+    if (ty < 0)
+        ty = 0;
+    else if (ty >= g_game.room_height)
+        ty = g_game.room_height - 1;
+
+    const u32 *row = mask + ty * g_game.room_colmask_pitch;
+    u32 bits;
+
+    if (tx >= 0 && tx + n <= g_game.room_width)
+    {
+        uint sh = (uint)tx & 31;
+        const u32 *word = row + (tx >> 5);
+
+        bits = word[0] >> sh;
+        if (sh + n > 32)
+            bits |= word[1] << (32 - sh);
+    }
+    else
+    {
+        // slow path for ranges that go past the room edges. only really
+        // happens during room transitions.
+        bits = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            int x = tx + i;
+            if (x < 0)
+                x = 0;
+            else if (x >= g_game.room_width)
+                x = g_game.room_width - 1;
+
+            bits |= ((row[x >> 5] >> (x & 31)) & 1) << i;
+        }
+    }
+
+    if (n < 32)
+        bits &= (1u << n) - 1;
+
+    return bits;
+}
+
+static inline u32 game_get_solid_bits(int tx, int ty, int n)
+{
+    return game_colmask_get_bits(g_game.room_solid_mask, tx, ty, n);
+}
+
+static inline u32 game_get_water_bits(int tx, int ty, int n)
+{
+    return game_colmask_get_bits(g_game.room_water_mask, tx, ty, n);
+}
+
 void entity_player_init(entity_s *self);
 void entity_player_droplet_init(entity_s *self, FIXED px, FIXED py,
                                 int type, int dir);
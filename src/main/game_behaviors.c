@@ -10,6 +10,7 @@
 
 #include "dialogue.h"
 #include "game.h"
+#include "game_query.h"
 #include "math_util.h"
 #include "scenes.h"
 #include "sound.h"
@@ -34,21 +35,26 @@
     static_assert(sizeof(strt) <= sizeof(uintptr_t) * 4, \
                   "struct '" #strt "' exceeds storage capcity");
 
-#define MSG_ID_BROKE_STALACTITE "brkstalc"
-#define MSG_ID_STALACTITE_ATTACK "atkstalc"
-
+// platforms can be placed in air or water. but not in water that's right
+// under a ceiling.
 static bool droplet_check_tile(FIXED x, FIXED y)
 {
-    int tx = x / (WORLD_TILE_SIZE * FIX_ONE);
-    int ty = y / (WORLD_TILE_SIZE * FIX_ONE);
-    if (tx < 0) --tx;
-    if (ty < 0) --ty;
+    if (game_query_point(x, y, QUERY_TILE_AIR)) return true;
+    if (!game_query_point(x, y, QUERY_TILE_WATER)) return false;
+
+    return game_query_point(x, y - int2fx(WORLD_TILE_SIZE),
+                            QUERY_TILE_AIR | QUERY_TILE_WATER);
+}
 
-    int col = game_get_col_clamped(tx, ty);
-    if (col == 2)
-        col = game_get_col_clamped(tx, ty - 1);
+// checks the left edge, middle and right edge of a platform placed at (x, y)
+static bool droplet_platform_fits(FIXED x, FIXED y)
+{
+    const FIXED test_x = x + int2fx(3);
+    const FIXED test_y = y + int2fx(1);
 
-    return col == 0 || col == 2;
+    return droplet_check_tile(test_x,             test_y) &&
+           droplet_check_tile(test_x + int2fx(3), test_y) &&
+           droplet_check_tile(test_x - int2fx(3), test_y);
 }
 
 
@@ -118,10 +124,11 @@ static bool enemy_base_proj_touch(entity_s *self, projectile_s *proj,
     if (--data->health == 0)
     {
         data->health = -1;
-        self->flags &= ~(ENTITY_FLAG_ACTOR | ENTITY_FLAG_COLLIDE | ENTITY_FLAG_DAMPING);
-        self->flags |= ENTITY_FLAG_MOVING;
+        entity_clear_flags(self, ENTITY_FLAG_ACTOR | ENTITY_FLAG_COLLIDE |
+                                 ENTITY_FLAG_DAMPING);
+        entity_set_flags(self, ENTITY_FLAG_MOVING);
         self->sprite.graphic_id = dead_gfx;
-        self->sprite.flags &= ~SPRITE_FLAG_PLAYING;
+        entity_set_playing(self, false);
         self->sprite.frame = 0;
         self->sprite.accum = 0;
         self->col.group = 0;
@@ -178,8 +185,8 @@ void entity_player_init(entity_s *self)
 {
     player_data_s *data = (player_data_s *)self->userdata;
 
-    self->flags |= ENTITY_FLAG_MOVING | ENTITY_FLAG_COLLIDE | ENTITY_FLAG_ACTOR
-                   | ENTITY_FLAG_KEEP_ON_ROOM_CHANGE;
+    entity_set_flags(self, ENTITY_FLAG_MOVING | ENTITY_FLAG_COLLIDE |
+                           ENTITY_FLAG_ACTOR | ENTITY_FLAG_KEEP_ON_ROOM_CHANGE);
     self->col.w = 6;
     self->col.h = 8;
     self->col.group = COLGROUP_ACTOR;
@@ -190,15 +197,15 @@ void entity_player_init(entity_s *self)
     self->sprite.ox = -1;
     self->sprite.oy = -8;
     self->sprite.graphic_id = SPRID_GAME_PLAYER_IDLE;
-    self->sprite.flags |= SPRITE_FLAG_PLAYING;
-    self->behavior = &behavior_player;
+    entity_set_playing(self, true);
+    entity_set_behavior(self, &behavior_player);
 
     *data = (player_data_s){0};
 
     entity_s *cursor = entity_alloc();
     if (!cursor) return;
 
-    cursor->flags |= ENTITY_FLAG_KEEP_ON_ROOM_CHANGE;
+    entity_set_flags(cursor, ENTITY_FLAG_KEEP_ON_ROOM_CHANGE);
     cursor->sprite.graphic_id = SPRID_GAME_PLATFORM_OUTLINE;
     cursor->sprite.palette = GFX_OBJPAL_USER0;
     cursor->sprite.ox = -1;
@@ -249,36 +256,30 @@ static bool player_simulate_droplet(int droplet_type, int dir, FIXED player_x,
 
     target_y = fxmul(FX_FLOOR(fxdiv(target_y, WORLD_TILE_SIZE)), WORLD_TILE_SIZE);
 
-    while (true)
-    {
-        vy += fxmul(WORLD_GRAVITY, PLAYER_SPIT_G_MULT);
-        px += vx;
-        py += vy;
-
-        FIXED cx = FX_FLOOR(px + int2fx(4) + FIX_ONE / 2);
-        FIXED cy = FX_FLOOR(py + int2fx(4) + FIX_ONE / 2);
+    // the droplet lands on the first frame it's falling with its center,
+    // rounded down to a whole pixel, at or below target_y. so solve for
+    // that frame directly instead of stepping through the whole arc.
+    const FIXED land_y = FX_FLOOR(target_y + FIX_ONE - 1) - int2fx(4) -
+                         FIX_ONE / 2;
+    int steps = game_query_fall_steps(py, vy,
+                                      fxmul(WORLD_GRAVITY, PLAYER_SPIT_G_MULT),
+                                      land_y);
+    px += vx * steps;
 
-        if (vy > 0 && cy >= target_y)
-        {
-            const FIXED x_snap = int2fx(WORLD_TILE_SIZE / 2);
-            const FIXED tile_size = int2fx(WORLD_TILE_SIZE);
-            
-            FIXED plat_x = fxmul(FX_FLOOR(fxdiv(cx, x_snap) - FIX_ONE / 2 - 1), x_snap);
-            FIXED plat_y = fxmul(FX_FLOOR(fxdiv(target_y, tile_size)), tile_size);
-            plat_x = FX_FLOOR(plat_x) + FIX_ONE;
-            plat_y = FX_FLOOR(plat_y);
+    FIXED cx = FX_FLOOR(px + int2fx(4) + FIX_ONE / 2);
 
-            *out_x = plat_x;
-            *out_y = plat_y;
+    const FIXED x_snap = int2fx(WORLD_TILE_SIZE / 2);
+    const FIXED tile_size = int2fx(WORLD_TILE_SIZE);
+    
+    FIXED plat_x = fxmul(FX_FLOOR(fxdiv(cx, x_snap) - FIX_ONE / 2 - 1), x_snap);
+    FIXED plat_y = fxmul(FX_FLOOR(fxdiv(target_y, tile_size)), tile_size);
+    plat_x = FX_FLOOR(plat_x) + FIX_ONE;
+    plat_y = FX_FLOOR(plat_y);
 
-            FIXED test_x = plat_x + int2fx(3);
-            FIXED test_y = plat_y + int2fx(1);
+    *out_x = plat_x;
+    *out_y = plat_y;
 
-            return (droplet_check_tile(test_x,             test_y) &&
-                   droplet_check_tile(test_x + int2fx(3), test_y) &&
-                   droplet_check_tile(test_x - int2fx(3), test_y));
-        }
-    }
+    return droplet_platform_fits(plat_x, plat_y);
 }
 
 static bool player_platform_spit(entity_s *self)
@@ -316,7 +317,7 @@ static bool player_platform_spit(entity_s *self)
         self->sprite.graphic_id = SPRID_GAME_PLAYER_SPIT;
         self->sprite.accum = 0;
         self->sprite.frame = 0;
-        self->sprite.flags |= SPRITE_FLAG_PLAYING;
+        entity_set_playing(self, true);
         self->vel.x = 0;
     }
 
@@ -335,6 +336,7 @@ static bool player_bullet_spit(entity_s *self)
 
     LOG_DBG("create player bullet");
 
+    proj->owner = self - g_game.entities;
     proj->px = self->pos.x + int2fx(self->col.w) / 2;
     proj->py = self->pos.y + int2fx(self->col.h) / 2;
 
@@ -401,7 +403,7 @@ static void behavior_player_update(entity_s *self)
 
             self->vel.x = 0;
             self->vel.y = 0;
-            self->flags &= ~(ENTITY_FLAG_COLLIDE | ENTITY_FLAG_MOVING);
+            entity_clear_flags(self, ENTITY_FLAG_COLLIDE | ENTITY_FLAG_MOVING);
             if (key_is_down(KEY_RIGHT))
                 self->pos.x += int2fx(3);
             if (key_is_down(KEY_LEFT))
@@ -410,7 +412,7 @@ static void behavior_player_update(entity_s *self)
                 self->pos.y += int2fx(3);
             if (key_is_down(KEY_UP))
                 self->pos.y -= int2fx(3);
-        } else self->flags |= (ENTITY_FLAG_COLLIDE | ENTITY_FLAG_MOVING);
+        } else entity_set_flags(self, ENTITY_FLAG_COLLIDE | ENTITY_FLAG_MOVING);
 #endif
 
         int actor_flags = (int) self->actor.flags;
@@ -526,7 +528,7 @@ static void behavior_player_update(entity_s *self)
         self->sprite.graphic_id = anim;
         self->sprite.accum = 0;
         self->sprite.frame = 0;
-        self->sprite.flags |= SPRITE_FLAG_PLAYING;
+        entity_set_playing(self, true);
     }
 
     skip_animation:;
@@ -577,8 +579,8 @@ static void behavior_player_update(entity_s *self)
 
     if (self->col.flags & COL_FLAG_IN_WATER)
     {
-        self->flags &= ~ENTITY_FLAG_ACTOR;
-        self->flags |= ENTITY_FLAG_DAMPING;
+        entity_clear_flags(self, ENTITY_FLAG_ACTOR);
+        entity_set_flags(self, ENTITY_FLAG_DAMPING);
         self->damp = TO_FIXED(0.8);
         self->sprite.graphic_id = SPRID_GAME_PLAYER_FROZEN;
         self->sprite.frame = 0;
@@ -603,7 +605,7 @@ static void player_hit_by_stalactite(entity_s *self, entity_s *other)
     player_data_s *data = (player_data_s *)self->userdata;
     if (data->death_timer != -1) return;
 
-    self->flags &= ~ENTITY_FLAG_ACTOR;
+    entity_clear_flags(self, ENTITY_FLAG_ACTOR);
     self->vel.x = 0;
     self->vel.y = other->vel.y;
 
@@ -623,7 +625,7 @@ static void behavior_player_attacked(entity_s *self, entity_s *attacker,
     player_data_s *data = (player_data_s *)self->userdata;
     if (data->death_timer != -1) return;
 
-    self->flags &= ~(ENTITY_FLAG_COLLIDE | ENTITY_FLAG_ACTOR);
+    entity_clear_flags(self, ENTITY_FLAG_COLLIDE | ENTITY_FLAG_ACTOR);
 
     // note: the original unyuland has a bug where the kinematics of fallen
     // enemies are ticked twice, so the numbers need to be adjusted here
@@ -658,11 +660,10 @@ static bool behavior_player_proj_touch(entity_s *self, projectile_s *proj)
     return false;
 }
 
-static bool behavior_player_message(entity_s *self, const char *id, void *ud)
+static bool behavior_player_message(entity_s *self, entity_msg_e id,
+                                    void *ud)
 {
-    (void)ud;
-
-    if (!strcmp(id, MSG_ID_STALACTITE_ATTACK))
+    if (id == ENTITY_MSG_STALACTITE_ATTACK)
     {
         player_hit_by_stalactite(self, ud);
         return true;
@@ -710,8 +711,8 @@ void entity_player_droplet_init(entity_s *self, FIXED px, FIXED py, int type,
                                 int dir)
 {
     player_bullet_data_s *data = (player_bullet_data_s *)&self->userdata;
-    self->behavior = &behavior_player_droplet;
-    self->flags |= ENTITY_FLAG_MOVING;
+    entity_set_behavior(self, &behavior_player_droplet);
+    entity_set_flags(self, ENTITY_FLAG_MOVING);
     self->gmult = PLAYER_SPIT_G_MULT;
     self->pos.x = px - int2fx(4);
     self->pos.y = py - int2fx(4);
@@ -766,12 +767,7 @@ static void behavior_player_droplet_update(entity_s *self)
         px = FX_FLOOR(px) + FIX_ONE;
         py = FX_FLOOR(py);
 
-        FIXED test_x = px + int2fx(3);
-        FIXED test_y = py + int2fx(1);
-
-        bool valid = (droplet_check_tile(test_x,             test_y) &&
-                     droplet_check_tile(test_x + int2fx(3), test_y) &&
-                     droplet_check_tile(test_x - int2fx(3), test_y));
+        bool valid = droplet_platform_fits(px, py);
 
         // newly created platform is free to override this entity slot.
         // obviously, self is now an invalid pointer, so don't dereference it
@@ -781,7 +777,8 @@ static void behavior_player_droplet_update(entity_s *self)
         if (valid)
         {
             entity_s *platf = entity_alloc();
-            platf->flags |= ENTITY_FLAG_COLLIDE | ENTITY_FLAG_REMOVE_ON_CHECKPOINT;
+            entity_set_flags(platf, ENTITY_FLAG_COLLIDE |
+                                    ENTITY_FLAG_REMOVE_ON_CHECKPOINT);
             platf->pos.x = px;
             platf->pos.y = py;
             platf->col.w = 6;
@@ -834,8 +831,9 @@ EDATA_SIZE_CHECK(crawler_data_s)
 void entity_crawler_init(entity_s *self, FIXED px, FIXED py, FIXED max_dist)
 {
     crawler_data_s *data = (crawler_data_s *)&self->userdata;
-    self->behavior = &behavior_crawler;
-    self->flags |= ENTITY_FLAG_MOVING | ENTITY_FLAG_COLLIDE | ENTITY_FLAG_ACTOR;
+    entity_set_behavior(self, &behavior_crawler);
+    entity_set_flags(self, ENTITY_FLAG_MOVING | ENTITY_FLAG_COLLIDE |
+                           ENTITY_FLAG_ACTOR);
     self->pos.x = px + int2fx(1);
     self->pos.y = py;
     self->col.w = 6;
@@ -843,7 +841,7 @@ void entity_crawler_init(entity_s *self, FIXED px, FIXED py, FIXED max_dist)
     self->col.group = COLGROUP_ACTOR;
     self->col.mask = COLGROUP_DEFAULT | COLGROUP_PLR_PLAT | COLGROUP_PROJECTILE;
     self->sprite.graphic_id = SPRID_GAME_CRAWLER_WALK;
-    self->sprite.flags |= SPRITE_FLAG_PLAYING;
+    entity_set_playing(self, true);
     self->sprite.ox = -1;
     self->actor.face_dir = 1;
     self->actor.move_speed = TO_FIXED(0.5);
@@ -924,7 +922,7 @@ EDATA_SIZE_CHECK(gun_enemy_data_s)
 void entity_gun_enemy_init(entity_s *self, FIXED px, FIXED py, bool ceil,
                            int dir_flags)
 {
-    self->flags |= ENTITY_FLAG_COLLIDE;
+    entity_set_flags(self, ENTITY_FLAG_COLLIDE);
     self->pos.x = px + int2fx(1);
     self->pos.y = py;
     self->col.w = 6;
@@ -940,12 +938,12 @@ void entity_gun_enemy_init(entity_s *self, FIXED px, FIXED py, bool ceil,
     }
     else
     {
-        self->flags |= ENTITY_FLAG_MOVING | ENTITY_FLAG_DAMPING;
+        entity_set_flags(self, ENTITY_FLAG_MOVING | ENTITY_FLAG_DAMPING);
         self->sprite.oy = -4;
         self->damp = DEFAULT_DAMP;
     }
 
-    self->behavior = &behavior_gun_enemy;
+    entity_set_behavior(self, &behavior_gun_enemy);
 
     gun_enemy_data_s *data = (gun_enemy_data_s *)self->userdata;
     *data = (gun_enemy_data_s)
@@ -957,11 +955,13 @@ void entity_gun_enemy_init(entity_s *self, FIXED px, FIXED py, bool ceil,
     };
 }
 
-static void gun_enemy_shoot(FIXED x, FIXED y, FIXED vx, FIXED vy)
+static void gun_enemy_shoot(entity_s *self, FIXED x, FIXED y, FIXED vx,
+                            FIXED vy)
 {
     projectile_s *proj = projectile_alloc();
     if (!proj) return;
 
+    proj->owner = self - g_game.entities;
     proj->px = x;
     proj->py = y;
     proj->vx = vx;
@@ -987,34 +987,34 @@ static void behavior_gun_enemy_update(entity_s *self)
         int dir_flags = data->dir_flags;
 
         if (dir_flags & GUN_ENEMY_DIRFLAG_R)
-            gun_enemy_shoot(px, py,
+            gun_enemy_shoot(self, px, py,
                             TO_FIXED(GUN_ENEMY_PROJ_SPEED),
                             TO_FIXED(0.0));
 
         if (dir_flags & GUN_ENEMY_DIRFLAG_TR)
-            gun_enemy_shoot(px, py,
+            gun_enemy_shoot(self, px, py,
                             TO_FIXED(COS45 * GUN_ENEMY_PROJ_SPEED),
                             yfac * TO_FIXED(-COS45 * GUN_ENEMY_PROJ_SPEED));
 
         if (dir_flags & GUN_ENEMY_DIRFLAG_T)
-            gun_enemy_shoot(px, py,
+            gun_enemy_shoot(self, px, py,
                             TO_FIXED(0),
                             yfac * TO_FIXED(-GUN_ENEMY_PROJ_SPEED));
 
         if (dir_flags & GUN_ENEMY_DIRFLAG_TL)
-            gun_enemy_shoot(px, py,
+            gun_enemy_shoot(self, px, py,
                             TO_FIXED(-COS45 * GUN_ENEMY_PROJ_SPEED),
                             yfac * TO_FIXED(-COS45 * GUN_ENEMY_PROJ_SPEED));
 
         if (dir_flags & GUN_ENEMY_DIRFLAG_L)
-            gun_enemy_shoot(px, py,
+            gun_enemy_shoot(self, px, py,
                             TO_FIXED(-GUN_ENEMY_PROJ_SPEED),
                             TO_FIXED(0.0));
         
         self->sprite.graphic_id = SPRID_GAME_GUN_ENEMY_FIRE;
         self->sprite.frame = 0;
         self->sprite.accum = 0;
-        self->sprite.flags |= SPRITE_FLAG_PLAYING;
+        entity_set_playing(self, true);
 
         int screen_dx = fx2int(self->pos.x - g_game.cam_x);
         int screen_dy = fx2int(self->pos.y - g_game.cam_y);
@@ -1058,9 +1058,9 @@ const behavior_def_s behavior_gun_enemy = {
 
 void entity_ice_block_init(entity_s *self, FIXED px, FIXED py)
 {
-    self->flags |=   ENTITY_FLAG_COLLIDE
-                   | ENTITY_FLAG_MOVING
-                   | ENTITY_FLAG_DAMPING;
+    entity_set_flags(self,   ENTITY_FLAG_COLLIDE
+                           | ENTITY_FLAG_MOVING
+                           | ENTITY_FLAG_DAMPING);
     self->pos.x = px;
     self->pos.y = py;
     self->col.w = 8;
@@ -1114,8 +1114,8 @@ void entity_spring_init(entity_s *self, FIXED px, FIXED py, bool super)
 {
     spring_data_s *data = (spring_data_s *)self->userdata;
 
-    self->flags |= ENTITY_FLAG_COLLIDE | ENTITY_FLAG_MOVING
-                   | ENTITY_FLAG_DAMPING;
+    entity_set_flags(self, ENTITY_FLAG_COLLIDE | ENTITY_FLAG_MOVING
+                           | ENTITY_FLAG_DAMPING);
     self->pos.x = px;
     self->pos.y = py;
     self->col.w = 8;
@@ -1123,7 +1123,7 @@ void entity_spring_init(entity_s *self, FIXED px, FIXED py, bool super)
     self->mass = 4;
     self->damp = DEFAULT_DAMP;
     self->sprite.graphic_id = super ? SPRID_GAME_SUPER_SPRING : SPRID_GAME_SPRING;
-    self->behavior = &behavior_spring;
+    entity_set_behavior(self, &behavior_spring);
     data->launch_vel = super ? TO_FIXED(-6.0) : TO_FIXED(-3.0);
 }
 
@@ -1163,7 +1163,7 @@ static void home_interact(entity_s *self, entity_s *source)
 
 void entity_home_init(entity_s *self, FIXED px, FIXED py)
 {
-    self->flags |= ENTITY_FLAG_COLLIDE;
+    entity_set_flags(self, ENTITY_FLAG_COLLIDE);
     self->pos.x = px;
     self->pos.y = py;
     self->col.w = 8;
@@ -1173,7 +1173,7 @@ void entity_home_init(entity_s *self, FIXED px, FIXED py)
     self->sprite.ox = -4;
     self->sprite.oy = -16;
     self->sprite.zidx = -20;
-    self->behavior = &behavior_home;
+    entity_set_behavior(self, &behavior_home);
 }
 
 static const behavior_def_s behavior_home = {
@@ -1208,7 +1208,7 @@ EDATA_SIZE_CHECK(sign_data_s);
 void entity_sign_init(entity_s *self, FIXED px, FIXED py, const char *dialogue,
                       bool alt_appearance)
 {
-    self->flags |= ENTITY_FLAG_COLLIDE;
+    entity_set_flags(self, ENTITY_FLAG_COLLIDE);
     self->pos.x = px;
     self->pos.y = py;
     self->col.w = 8;
@@ -1216,7 +1216,7 @@ void entity_sign_init(entity_s *self, FIXED px, FIXED py, const char *dialogue,
     self->col.flags = COL_FLAG_MONITOR_ONLY;
     self->sprite.graphic_id = alt_appearance ? SPRID_GAME_HINT_SIGN : SPRID_GAME_SIGN;
     self->sprite.zidx = -20;
-    self->behavior = &behavior_sign;
+    entity_set_behavior(self, &behavior_sign);
 
     sign_data_s *data = (sign_data_s *)self->userdata;
     data->dialogue = dialogue;
@@ -1254,7 +1254,7 @@ const behavior_def_s behavior_water_tank;
 
 void entity_water_tank_init(entity_s *self, FIXED px, FIXED py)
 {
-    self->flags |= ENTITY_FLAG_COLLIDE;
+    entity_set_flags(self, ENTITY_FLAG_COLLIDE);
     self->pos.x = px + int2fx(1);
     self->pos.y = py - int2fx(4);
     self->col.w = 6;
@@ -1264,7 +1264,7 @@ void entity_water_tank_init(entity_s *self, FIXED px, FIXED py)
     self->sprite.ox = -1;
     self->sprite.oy = -4;
     self->sprite.zidx = -20;
-    self->behavior = &behavior_water_tank;
+    entity_set_behavior(self, &behavior_water_tank);
 }
 
 static void behavior_water_tank_interact(entity_s *self, entity_s *source)
@@ -1337,13 +1337,13 @@ EDATA_SIZE_CHECK(fragile_block_data_s)
 
 void entity_fragile_block_init(entity_s *self, FIXED px, FIXED py)
 {
-    self->flags |= ENTITY_FLAG_COLLIDE;
+    entity_set_flags(self, ENTITY_FLAG_COLLIDE);
     self->pos.x = px;
     self->pos.y = py;
     self->col.w = 8;
     self->col.h = 8;
     self->sprite.graphic_id = SPRID_GAME_FRAGILE_BLOCK_RED;
-    self->behavior = &behavior_fragile_block;
+    entity_set_behavior(self, &behavior_fragile_block);
 
     fragile_block_data_s *data = (fragile_block_data_s *)self->userdata;
     data->hits = 0;
@@ -1395,7 +1395,7 @@ EDATA_SIZE_CHECK(orb_data_s)
 
 void entity_orb(entity_s *self, FIXED px, FIXED py, bool blue)
 {
-    self->flags |= ENTITY_FLAG_COLLIDE;
+    entity_set_flags(self, ENTITY_FLAG_COLLIDE);
     self->pos.x = px + int2fx(2);
     self->pos.y = py;
     self->col.w = 4;
@@ -1405,8 +1405,8 @@ void entity_orb(entity_s *self, FIXED px, FIXED py, bool blue)
                                    : SPRID_GAME_FIRE_ORB_RED;
     self->sprite.ox = -2;
     self->sprite.oy = -2;
-    self->sprite.flags |= SPRITE_FLAG_PLAYING;
-    self->behavior = &behavior_orb;
+    entity_set_playing(self, true);
+    entity_set_behavior(self, &behavior_orb);
 
     orb_data_s *data = (orb_data_s *)self->userdata;
     data->frame = 0;
@@ -1531,7 +1531,7 @@ EDATA_SIZE_CHECK(stalactite_data_s)
 
 void entity_stalactite_init(entity_s *self, FIXED px, FIXED py, int gfx_variant)
 {
-    self->flags |= ENTITY_FLAG_COLLIDE;
+    entity_set_flags(self, ENTITY_FLAG_COLLIDE);
     self->pos.x = px - FX(STALACTITE_EXTRA_WIDTH) / 2;
     self->pos.y = py;
     self->col.w = 8 + STALACTITE_EXTRA_WIDTH;
@@ -1542,7 +1542,7 @@ void entity_stalactite_init(entity_s *self, FIXED px, FIXED py, int gfx_variant)
     self->sprite.frame = gfx_variant - 1;
     self->sprite.ox = STALACTITE_EXTRA_WIDTH / 2;
     self->sprite.palette = GFX_OBJPAL_USER3;
-    self->behavior = &behavior_stalactite;
+    entity_set_behavior(self, &behavior_stalactite);
 
     stalactite_data_s *data = (stalactite_data_s *)self->userdata;
     *data = (stalactite_data_s){
@@ -1565,7 +1565,7 @@ static bool stalactite_proj_touch(entity_s *self, projectile_s *proj)
 
     // enable actor flag just so it can detect if it touched the ground
     // (sucks i know. but i'm too lazy at this point.)
-    self->flags |= ENTITY_FLAG_MOVING | ENTITY_FLAG_ACTOR;
+    entity_set_flags(self, ENTITY_FLAG_MOVING | ENTITY_FLAG_ACTOR);
     self->actor.flags |= ACTOR_FLAG_NO_VEL;
     self->col.mask = COLGROUP_DEFAULT;
     self->col.w = 8;
@@ -1573,7 +1573,7 @@ static bool stalactite_proj_touch(entity_s *self, projectile_s *proj)
     data->falling = true;
     data->sprite_ox = 0;
 
-    game_send_global_message(MSG_ID_BROKE_STALACTITE, self);
+    game_send_global_message(ENTITY_MSG_BROKE_STALACTITE, self);
     return false;
 }
 
@@ -1584,7 +1584,10 @@ static void stalactite_ent_touch(entity_s *self, entity_s *other, int nx, int ny
     if (!(other->col.group & COLGROUP_ACTOR)) return;
 
     if (other->behavior && other->behavior->message)
-        other->behavior->message(other, MSG_ID_STALACTITE_ATTACK, self);
+    {
+        other->behavior->message(other, ENTITY_MSG_STALACTITE_ATTACK,
+                                 self);
+    }
 
     if (other->behavior && other->behavior->attacked)
         other->behavior->attacked(other, self, 0);
@@ -1704,8 +1707,8 @@ static void boss_switch_mode(entity_s *self, boss_mode_e mode);
 
 void entity_boss_init(entity_s *self, FIXED px, FIXED py)
 {
-    self->flags |= ENTITY_FLAG_MOVING | ENTITY_FLAG_COLLIDE |
-                   ENTITY_FLAG_ACTOR | ENTITY_FLAG_GLOBAL_MSG;
+    entity_set_flags(self, ENTITY_FLAG_MOVING | ENTITY_FLAG_COLLIDE |
+                           ENTITY_FLAG_ACTOR | ENTITY_FLAG_GLOBAL_MSG);
     self->pos.x = px;
     self->pos.y = py;
     self->col.w = 16;
@@ -1718,7 +1721,7 @@ void entity_boss_init(entity_s *self, FIXED px, FIXED py)
     self->mass = 8;
     self->sprite.graphic_id = SPRID_GAME_BOSS_IDLE;
     self->sprite.oy = -4;
-    self->behavior = &behavior_boss;
+    entity_set_behavior(self, &behavior_boss);
 
     boss_data_s *data = (boss_data_s *)self->userdata;
     *data = (boss_data_s){
@@ -1734,6 +1737,7 @@ static projectile_s *boss_shoot(entity_s *self, FIXED px, FIXED py, FIXED dx,
     projectile_s *proj = projectile_alloc();
     if (!proj) return NULL;
 
+    proj->owner = self - g_game.entities;
     proj->px = px;
     proj->py = py;
     proj->vx = fxmul(dx, mul);
@@ -2216,13 +2220,14 @@ static void behavior_boss_update(entity_s *self)
     }
 
     self->flags = (self->flags & ~BOSS_ENT_FLAG_MASK) | (ent_flags & BOSS_ENT_FLAG_MASK);
+    entity_update_caps(self);
 
     if (self->sprite.graphic_id != gfx_id)
     {
         self->sprite.graphic_id = gfx_id;
         self->sprite.accum = 0;
         self->sprite.frame = 0;
-        self->sprite.flags |= SPRITE_FLAG_PLAYING;
+        entity_set_playing(self, true);
     }
 
     if (clamp_position)
@@ -2317,11 +2322,11 @@ static void behavior_boss_attacked(entity_s *self, entity_s *other, int dir)
     boss_switch_mode(self, BOSS_MODE_HURT);
 }
 
-static bool behavior_boss_message(entity_s *self, const char *id,
+static bool behavior_boss_message(entity_s *self, entity_msg_e id,
                                   void *msg_data)
 {
     // only reacts to stalactite broke message
-    if (strcmp(id, MSG_ID_BROKE_STALACTITE)) return false;
+    if (id != ENTITY_MSG_BROKE_STALACTITE) return false;
 
     LOG_DBG("sensed broken stalactite");
 
@@ -2348,6 +2353,7 @@ static const behavior_def_s behavior_boss = {
     .ent_touch = behavior_boss_ent_touch,
     .attacked = behavior_boss_attacked,
     .message = behavior_boss_message,
+    .global_msgs = ENTITY_MSG_BIT(ENTITY_MSG_BROKE_STALACTITE)
 };
 
 #pragma endregion boss
\ No newline at end of file
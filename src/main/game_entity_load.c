@@ -1,110 +1,15 @@
-#include <string.h>
 #include <log.h>
 #include "game.h"
 #include "dialogue.h"
 
-#define STR_CASE(case) else if (!strcmp(__match, (case)))
-#define STR_CASE_START(match) { const char *__match = (match); if (false) {}
-#define STR_CASE_FALLBACK else
-#define STR_CASE_END }
-
-static bool get_property(const entity_load_s *load_data, const char *name,
-                         int type, uintptr_t *out)
-{
-    entity_load_prop_s *prop = load_data->props;
-    entity_load_prop_s *end_prop = load_data->props + load_data->prop_count;
-    for (; prop != end_prop; ++prop)
-    {
-        if (!strcmp(prop->name, name) && prop->type == type)
-        {
-            *out = prop->data;
-            return true;
-        }
-    }
-    return false;
-}
-
-static inline bool get_property_string(const entity_load_s *load_data,
-                                       const char *name, const char **p_out)
+static const char* get_sign_text(const mapc_spawn_s *spawn)
 {
-    uintptr_t out = 0;
-    bool s = get_property(load_data, name, ELPT_STRING, &out);
-    *p_out = (const char *)out;
-    return s;
+    // mapc already made sure the chat exists
+    if (spawn->arg < 0) return NULL;
+    return dlg_get_chat_data(spawn->arg);
 }
 
-static inline bool get_property_decimal(const entity_load_s *load_data,
-                                        const char *name, FIXED *p_out)
-{
-    uintptr_t out = 0;
-    bool s = get_property(load_data, name, ELPT_DECIMAL, &out);
-    *p_out = (FIXED) out;
-    return s;
-}
-
-static inline bool get_property_int(const entity_load_s *load_data,
-                                    const char *name, int *p_out)
-{
-    uintptr_t out = 0;
-    bool s = get_property(load_data, name, ELPT_INT, &out);
-    *p_out = (int) out;
-    return s;
-}
-
-static int parse_gun_enemy_flags(const entity_load_s *load_data)
-{
-    const char *str;
-    if (!get_property_string(load_data, "fire_dir", &str))
-        return GUN_ENEMY_DIRFLAG_ALL;
-
-    int flags = 0;
-    for (; *str != 0; ++str)
-    {
-        switch (*str)
-        {
-        case 'L':
-            flags |= GUN_ENEMY_DIRFLAG_L;
-            break;
-        case 'T':
-            switch (*(str + 1))
-            {
-            case 'r':
-                flags |= GUN_ENEMY_DIRFLAG_TR;
-                ++str;
-                break;
-            case 'l':
-                flags |= GUN_ENEMY_DIRFLAG_TL;
-                ++str;
-                break;
-            default:
-                flags |= GUN_ENEMY_DIRFLAG_T;
-                break;
-            }
-            flags |= GUN_ENEMY_DIRFLAG_T;
-            break;
-        case 'R':
-            flags |= GUN_ENEMY_DIRFLAG_R;
-            break;
-        }
-    }
-
-    return flags;
-}
-
-static const char* parse_sign_text(const entity_load_s *load_data)
-{
-    const char *id;
-    if (!get_property_string(load_data, "text", &id))
-        return NULL;
-
-    const char *chat = dlg_get_chat_by_name(id);
-    if (!chat)
-        LOG_ERR("sign: could not find chat '%s'", id);
-
-    return chat;
-}
-
-static void load_orb(entity_s *ent, const entity_load_s *load_data, bool blue)
+static void load_orb(entity_s *ent, FIXED x, FIXED y, bool blue)
 {
     // don't spawn the orb if the orb in this room was already collected
     for (uint i = 0; i < g_game.collected_orbs_count; ++i)
@@ -116,99 +21,83 @@ static void load_orb(entity_s *ent, const entity_load_s *load_data, bool blue)
         }
     }
 
-    entity_orb(ent, load_data->x, load_data->y, blue);
+    entity_orb(ent, x, y, blue);
 }
 
-void game_load_entity(const entity_load_s *load_data)
+void game_load_entity(const mapc_spawn_s *spawn)
 {
-    const char *name = load_data->name;
+    const FIXED x = int2fx((int) spawn->x);
+    const FIXED y = int2fx((int) spawn->y);
 
     entity_s *ent = entity_alloc();
     if (!ent)
         return;
 
-    STR_CASE_START(name)
-    STR_CASE("crawler")
+    switch ((mapc_ent_type_e) spawn->type)
     {
-        FIXED max_dist;
-        if (!get_property_decimal(load_data, "max_dist", &max_dist))
-            max_dist = 0;
+    case MAPC_ENT_CRAWLER:
+        entity_crawler_init(ent, x, y, spawn->arg * WORLD_TILE_SIZE);
+        break;
 
-        entity_crawler_init(ent, load_data->x, load_data->y,
-                            max_dist * WORLD_TILE_SIZE);
-    }
-    STR_CASE("gun_enemy")
-    {
-        entity_gun_enemy_init(ent, load_data->x, load_data->y, false,
-                              parse_gun_enemy_flags(load_data));
-    }
-    STR_CASE("ceil_gun_enemy")
-    {
-        
-        entity_gun_enemy_init(ent, load_data->x, load_data->y, true,
-                              parse_gun_enemy_flags(load_data));
-    }
-    STR_CASE("ice_block")
-    {
-        entity_ice_block_init(ent, load_data->x, load_data->y);
-    }
-    STR_CASE("spring")
-    {
-        entity_spring_init(ent, load_data->x, load_data->y, false);
-    }
-    STR_CASE("super_spring")
-    {
-        entity_spring_init(ent, load_data->x, load_data->y, true);
-    }
-    STR_CASE("home")
-    {
-        entity_home_init(ent, load_data->x, load_data->y);
-    }
-    STR_CASE("sign")
-    {
-        entity_sign_init(ent, load_data->x, load_data->y,
-                         parse_sign_text(load_data), false);
-    }
-    STR_CASE("hint_sign")
-    {
-        entity_sign_init(ent, load_data->x, load_data->y,
-                         parse_sign_text(load_data), true);
-    }
-    STR_CASE("water_tank")
-    {
-        entity_water_tank_init(ent, load_data->x, load_data->y);
-    }
-    STR_CASE("static_fragile_block")
-    {
-        entity_fragile_block_init(ent, load_data->x, load_data->y);
-    }
-    STR_CASE("red_orb")
-    {
-        load_orb(ent, load_data, false);
-    }
-    STR_CASE("blue_orb")
-    {
-        load_orb(ent, load_data, true);
-    }
-    STR_CASE("stalactite")
-    {
-        int variant;
-        get_property_int(load_data, "variant", &variant);
-        entity_stalactite_init(ent, load_data->x, load_data->y, variant);
-    }
-    STR_CASE("boss")
-    {
-        entity_boss_init(ent, load_data->x, load_data->y);
-    }
-    STR_CASE_FALLBACK
-    {
-        LOG_DBG("unknown entity type %s", name);
-        goto error;
-    }
-    STR_CASE_END
+    case MAPC_ENT_GUN_ENEMY:
+        entity_gun_enemy_init(ent, x, y, false, spawn->arg);
+        break;
+
+    case MAPC_ENT_CEIL_GUN_ENEMY:
+        entity_gun_enemy_init(ent, x, y, true, spawn->arg);
+        break;
+
+    case MAPC_ENT_ICE_BLOCK:
+        entity_ice_block_init(ent, x, y);
+        break;
+
+    case MAPC_ENT_SPRING:
+        entity_spring_init(ent, x, y, false);
+        break;
+
+    case MAPC_ENT_SUPER_SPRING:
+        entity_spring_init(ent, x, y, true);
+        break;
+
+    case MAPC_ENT_HOME:
+        entity_home_init(ent, x, y);
+        break;
 
-    return;
+    case MAPC_ENT_SIGN:
+        entity_sign_init(ent, x, y, get_sign_text(spawn), false);
+        break;
 
-    error:
+    case MAPC_ENT_HINT_SIGN:
+        entity_sign_init(ent, x, y, get_sign_text(spawn), true);
+        break;
+
+    case MAPC_ENT_WATER_TANK:
+        entity_water_tank_init(ent, x, y);
+        break;
+
+    case MAPC_ENT_STATIC_FRAGILE_BLOCK:
+        entity_fragile_block_init(ent, x, y);
+        break;
+
+    case MAPC_ENT_RED_ORB:
+        load_orb(ent, x, y, false);
+        break;
+
+    case MAPC_ENT_BLUE_ORB:
+        load_orb(ent, x, y, true);
+        break;
+
+    case MAPC_ENT_STALACTITE:
+        entity_stalactite_init(ent, x, y, spawn->arg);
+        break;
+
+    case MAPC_ENT_BOSS:
+        entity_boss_init(ent, x, y);
+        break;
+
+    default:
+        LOG_DBG("unknown entity type %i", (int) spawn->type);
         entity_free(ent);
-}
\ No newline at end of file
+        break;
+    }
+}
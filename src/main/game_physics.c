@@ -5,8 +5,10 @@
 
 #include "game.h"
 #include "game_physics.h"
+#include "game_query.h"
 #include "datastruct.h"
 #include "math_util.h"
+#include "savestate.h"
 #include <platutil.h>
 
 //------------------------------------------------------------------------------
@@ -18,8 +20,8 @@
 
 #ifdef PHYS_PROFILE
 #define PROFILE_START() profile_start()
-#define PROFILE_END(t) profile.t += profile_stop()
-#define PROFILE_END2(t) profile.t = profile_stop()
+#define PROFILE_END(t) game_physics_profile.t += profile_stop()
+#define PROFILE_END2(t) game_physics_profile.t = profile_stop()
 #else
 #define PROFILE_START()
 #define PROFILE_END(t)
@@ -27,27 +29,19 @@
 #endif
 
 #ifdef PHYS_PROFILE
-struct phys_profile
-{
-    u32 detection_ent_t;
-    u32 detection_tile_t;
-    u32 resolution_t;
-    u32 move_t;
-    u32 start_t;
-    u32 projectiles_t;
-} profile;
+game_physics_profile_s game_physics_profile;
 
 #define PROFILE_LOG(str, n)  \
     do  \
     {  \
-        int v = profile.n * 100;  \
+        int v = game_physics_profile.n * 100;  \
         LOG_DBG(str ": %i.%02i%%", v / 280896, v % 280896 / 2809);  \
     } while (false)
 
 #define PROFILE_LOG_CYCLES(str, n)  \
     do  \
     {  \
-        LOG_DBG(str ": %i cycles", profile.n);  \
+        LOG_DBG(str ": %i cycles", game_physics_profile.n);  \
     } while (false)
 #endif
 
@@ -66,16 +60,42 @@ struct phys_profile
 //------------------------------------------------------------------------------
 #pragma region entity physics
 
-#define ENTITY_PAIR_SIZE \
-    IALIGN(CEIL_DIV(UPAIR2U(MAX_ENTITY_COUNT - 1, MAX_ENTITY_COUNT - 1), 8), 4)
-#define ENTITY_PAIR_GET(pairs, pkey) \
-    ((pairs[(pkey) >> 3] >> ((pkey) & 0x7)) & 0x1)
-#define ENTITY_PAIR_SET(pairs, pkey) \
-    (pairs[(pkey) >> 3] |= (1 << ((pkey) & 0x7)))
-#define ENTITY_PAIR_CLEAR(pairs, pkey) \
-    (pairs[(pkey) >> 3] &= ~(1 << ((pkey) & 0x7)))
+#define ENTITY_PAIR_COUNT \
+    (UPAIR2U(MAX_ENTITY_COUNT - 1, MAX_ENTITY_COUNT - 1) + 1)
 
 #define EDGE_LIST_MAX_COUNT ((MAX_ENTITY_COUNT * 2))
+#define WARM_CONTACT_MAX_COUNT MAX_CONTACT_COUNT
+#define WARM_SUPPORT_TILE 0xFFFF
+// room for four overlaps per body, which covers rooms full of crate stacks a
+// few crates tall. past that, overlaps are found by sweeping the edge list
+// until they fit again. (see physics_substeps_collect_contacts)
+#define OVERLAP_SET_MAX_COUNT ((MAX_ENTITY_COUNT * 4))
+#define OVERLAP_SLOT_NONE 0xFFFF // overlap_set_clear depends on this being 0xFFFF
+
+// how many frames in a row an island has to be at rest before it's put to
+// sleep
+#define PHYS_SLEEP_FRAMES 30
+
+// the overlap set's hash table. it's kept at most half full, so probe
+// sequences stay short.
+#if OVERLAP_SET_MAX_COUNT <= 128
+#define OVERLAP_HASH_BITS 8
+#elif OVERLAP_SET_MAX_COUNT <= 256
+#define OVERLAP_HASH_BITS 9
+#elif OVERLAP_SET_MAX_COUNT <= 512
+#define OVERLAP_HASH_BITS 10
+#elif OVERLAP_SET_MAX_COUNT <= 1024
+#define OVERLAP_HASH_BITS 11
+#else
+#error "MAX_ENTITY_COUNT too large"
+#endif
+
+#define OVERLAP_HASH_SIZE (1 << OVERLAP_HASH_BITS)
+#define OVERLAP_HASH_MASK (OVERLAP_HASH_SIZE - 1)
+
+// pair keys and list indices are both stored in a u16
+_Static_assert(ENTITY_PAIR_COUNT <= UINT16_MAX,
+               "MAX_ENTITY_COUNT too large");
 
 // collision-processing data for each active entity
 typedef struct entity_coldata
@@ -88,6 +108,14 @@ typedef struct entity_coldata
     bool head_bump;
     s8 x_anchor;
     s8 y_anchor;
+
+    // sleep state. while awake, sleep_x/sleep_y is the position at the start
+    // of the frame. while asleep, it's the position it fell asleep at, and
+    // island is the island it fell asleep with.
+    u8 still_frames;
+    bool no_sleep; // touched something with an ent_touch callback this frame
+    u16 island;
+    FIXED sleep_x, sleep_y;
 }
 entity_coldata_s;
 
@@ -96,7 +124,7 @@ typedef struct col_contact
     FIXED nx, ny, pd;
     entity_coldata_s *ent_a, *ent_b;
     u8 priority;
-    s16 tx, ty;
+    s16 tx, ty; // tile coordinates, for tile contacts
 }
 col_contact_s;
 
@@ -113,9 +141,46 @@ col_bp_edge_s;
 typedef struct col_bp_overlap
 {
     u16 eid_a, eid_b;
+    u16 pkey;
+    u16 prev, next; // neighbours in the set's list
 }
 col_bp_overlap_s;
 
+// set of overlaps on an axis. overlaps live in a pool, and are linked together
+// in the order they were added, which is the order contacts get collected in.
+// the hash table maps a pair key to the pool index of its overlap, so finding
+// one doesn't need a search, and removing one just unlinks it, without
+// changing the order of the rest. the table only holds pool indices, the key
+// of a slot is read from the pool entry it points to.
+//
+// the table is sized by the number of overlaps there can be, not by the
+// number of possible pairs, which grows quadratically with the entity count.
+// it has at least twice as many slots as that, so it's never more than half
+// full. if the pool runs out, the set is flagged as overflowed and stops
+// being used until it's rebuilt.
+typedef struct col_bp_overlap_set
+{
+    int count;
+    bool overflow;
+    u16 head, tail;
+    u16 free_head; // unused pool entries, linked through next
+    u16 slots[OVERLAP_HASH_SIZE];
+    col_bp_overlap_s pool[OVERLAP_SET_MAX_COUNT];
+}
+col_bp_overlap_set_s;
+
+// an anchored contact resolved in the previous substep, kept around for
+// warm-starting the next one. the normal points from the mover towards the
+// support.
+typedef struct col_warm_contact
+{
+    u16 mover;
+    u16 support; // WARM_SUPPORT_TILE if the support is a tile
+    FIXED nx, ny;
+    s16 tx, ty; // tile coordinates
+}
+col_warm_contact_s;
+
 // narrow-phase collision detection. contains penetration vector.
 typedef struct col_overlap_res {
     bool overlap;
@@ -126,21 +191,30 @@ static int col_ent_count = 0;
 static entity_coldata_s col_ent_map[MAX_ENTITY_COUNT];
 static entity_coldata_s *col_ents[MAX_ENTITY_COUNT];
 
+// slots in col_ent_map that have an entity, one bit each
+static u32 col_ent_mask[ENTITY_MASK_WORDS];
+
+// the actor list as of the last update, one bit each
+static u32 actor_ent_mask[ENTITY_MASK_WORDS];
+
 static uint col_contact_count = 0;
 static col_contact_s col_contacts[MAX_CONTACT_COUNT];
-// static u8 contact_pairs[ENTITY_PAIR_SIZE];
 
-static col_bp_overlap_s x_overlaps[MAX_ENTITY_COUNT * 2];
-static int x_overlap_count = 0;
+static col_bp_overlap_set_s x_overlaps;
+
+// warm-start contacts. one list is replayed at the start of a substep while
+// the other one is filled for the next.
+static int warm_contact_count[2];
+static col_warm_contact_s warm_contacts[2][WARM_CONTACT_MAX_COUNT];
+static int warm_contact_cur = 0;
 
 static int x_edge_count = 0;
 static col_bp_edge_s x_edges[EDGE_LIST_MAX_COUNT];
 
-static int y_edge_count = 0;
-static col_bp_edge_s y_edges[EDGE_LIST_MAX_COUNT];
-
-static u8 x_contact_pairs[ENTITY_PAIR_SIZE];
-static u8 y_contact_pairs[ENTITY_PAIR_SIZE];
+// islands of dynamic bodies that touched each other this frame, as a
+// union-find forest over col_ent_map indices. rebuilt every frame.
+static u16 island_parent[MAX_ENTITY_COUNT];
+static u8 island_still[MAX_ENTITY_COUNT];
 
 
 
@@ -183,10 +257,107 @@ static inline col_overlap_res_s rect_collision(FIXED x0, FIXED y0, FIXED hw0,
         return res;
 }
 
+// a body counts as static if it doesn't move, or if it's asleep. sleeping
+// bodies are treated just like static ones until something wakes them up.
+static inline bool body_is_static(const entity_s *ent)
+{
+    return !(ent->flags & ENTITY_FLAG_MOVING) ||
+           (ent->flags & ENTITY_FLAG_SLEEPING);
+}
+
+static inline bool has_ent_touch(const entity_s *ent)
+{
+    return ent->behavior && ent->behavior->ent_touch;
+}
+
+static inline int island_find(int i)
+{
+    while (island_parent[i] != i)
+    {
+        island_parent[i] = island_parent[island_parent[i]];
+        i = island_parent[i];
+    }
+
+    return i;
+}
+
+// join the islands of two touching bodies. only dynamic bodies form islands,
+// otherwise the floor would glue every body in the room into one island.
+static inline void island_link(const entity_coldata_s *a,
+                               const entity_coldata_s *b)
+{
+    if (!a || !b) return;
+    if (body_is_static(a->ent) || body_is_static(b->ent)) return;
+
+    int ra = island_find(a - col_ent_map);
+    int rb = island_find(b - col_ent_map);
+    if (ra != rb) island_parent[rb] = (u16) ra;
+}
+
+static void wake_body(entity_coldata_s *col_ent)
+{
+    entity_s *ent = col_ent->ent;
+    ent->flags &= ~ENTITY_FLAG_SLEEPING;
+    col_ent->still_frames = 0;
+    col_ent->dirty = true;
+    col_ent->sleep_x = ent->pos.x;
+    col_ent->sleep_y = ent->pos.y;
+}
+
+// islands sleep and wake up as a whole. a body is never left sleeping on top
+// of one that woke up.
+static void wake_island(int island)
+{
+    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+    {
+        entity_coldata_s *col_ent = col_ent_map + i;
+        if (!col_ent->ent) continue;
+        if (!(col_ent->ent->flags & ENTITY_FLAG_SLEEPING)) continue;
+        if (col_ent->island == island) wake_body(col_ent);
+    }
+}
+
+// called when a body stops colliding. static bodies don't join islands, so
+// wake up anything that is touching it too, in case it was resting on it.
+static void wake_around(int col_ent_idx)
+{
+    const entity_coldata_s *col = col_ent_map + col_ent_idx;
+    const entity_s *ent = col->ent;
+
+    if (ent->flags & ENTITY_FLAG_SLEEPING)
+        wake_island(col->island);
+
+    const FIXED l = ent->pos.x;
+    const FIXED t = ent->pos.y;
+    const FIXED r = l + col->width;
+    const FIXED b = t + col->height;
+
+    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+    {
+        entity_coldata_s *other = col_ent_map + i;
+        if (!other->ent || i == col_ent_idx) continue;
+        if (!(other->ent->flags & ENTITY_FLAG_SLEEPING)) continue;
+
+        const FIXED ol = other->ent->pos.x;
+        const FIXED ot = other->ent->pos.y;
+
+        // touching counts, since that's how bodies rest on each other
+        if (ol > r || ol + other->width < l) continue;
+        if (ot > b || ot + other->height < t) continue;
+
+        wake_island(other->island);
+    }
+}
+
 static void col_ent_added(int col_ent_idx)
 {
     LOG_DBG("col_ent_added %i", col_ent_idx);
 
+    // bodies always start out awake
+    entity_coldata_s *col = col_ent_map + col_ent_idx;
+    col->ent->flags &= ~ENTITY_FLAG_SLEEPING;
+    col->still_frames = 0;
+
     x_edges[x_edge_count++] = (col_bp_edge_s)
     {
         .eid = (u16) col_ent_idx,
@@ -197,55 +368,169 @@ static void col_ent_added(int col_ent_idx)
         .eid = (u16) col_ent_idx,
         .left = false
     };
+}
 
-    y_edges[y_edge_count++] = (col_bp_edge_s)
-    {
-        .eid = (u16) col_ent_idx,
-        .left = true
-    };
-    y_edges[y_edge_count++] = (col_bp_edge_s)
+static void overlap_set_clear(col_bp_overlap_set_s *set)
+{
+    set->count = 0;
+    set->overflow = false;
+    set->head = OVERLAP_SLOT_NONE;
+    set->tail = OVERLAP_SLOT_NONE;
+    memset32(set->slots, 0xFFFFFFFF, sizeof(set->slots) / 4);
+
+    set->free_head = 0;
+    for (int i = 0; i < OVERLAP_SET_MAX_COUNT; ++i)
+        set->pool[i].next = (u16)(i + 1);
+    set->pool[OVERLAP_SET_MAX_COUNT - 1].next = OVERLAP_SLOT_NONE;
+}
+
+static inline uint overlap_hash(uint pkey)
+{
+    return (pkey * 0x9E3779B1u) >> (32 - OVERLAP_HASH_BITS);
+}
+
+// returns the table index of the pair, or of the empty slot where it would go
+static inline uint overlap_set_find(const col_bp_overlap_set_s *set, uint pkey)
+{
+    uint h = overlap_hash(pkey);
+    for (;;)
     {
-        .eid = (u16) col_ent_idx,
-        .left = false
-    };
+        uint slot = set->slots[h];
+        if (slot == OVERLAP_SLOT_NONE || set->pool[slot].pkey == pkey)
+            return h;
+
+        h = (h + 1) & OVERLAP_HASH_MASK;
+    }
 }
 
-static void col_ent_removed(int col_ent_idx)
+static inline void overlap_set_add(col_bp_overlap_set_s *set, uint eid_a,
+                                   uint eid_b, uint pkey)
 {
-    LOG_DBG("col_ent_removed");
+    uint h = overlap_set_find(set, pkey);
+    if (set->slots[h] != OVERLAP_SLOT_NONE)
+    {
+        LOG_ERR("overlap already in set!");
+        return;
+    }
 
-    // remove x edge
-    for (int i = x_edge_count - 1; i >= 0; --i)
+    if (set->free_head == OVERLAP_SLOT_NONE)
     {
-        if (x_edges[i].eid == col_ent_idx)
-            DYNARR_REMOVE(x_edges, x_edge_count, i);
+        if (!set->overflow) LOG_DBG("overlap set full, sweeping instead");
+        set->overflow = true;
+        return;
     }
 
-    // remove x overlaps
-    for (int i = x_overlap_count - 1; i >= 0; --i)
+    const uint slot = set->free_head;
+    set->free_head = set->pool[slot].next;
+    ++set->count;
+
+    // link it in at the end of the list
+    set->pool[slot] = (col_bp_overlap_s)
+    {
+        .eid_a = (u16) eid_a,
+        .eid_b = (u16) eid_b,
+        .pkey = (u16) pkey,
+        .prev = set->tail,
+        .next = OVERLAP_SLOT_NONE
+    };
+
+    if (set->tail != OVERLAP_SLOT_NONE)
+        set->pool[set->tail].next = (u16) slot;
+    else
+        set->head = (u16) slot;
+    set->tail = (u16) slot;
+
+    set->slots[h] = (u16) slot;
+}
+
+// returns false if the pair was not in the set
+static inline bool overlap_set_remove(col_bp_overlap_set_s *set, uint pkey)
+{
+    uint h = overlap_set_find(set, pkey);
+    const uint slot = set->slots[h];
+    if (slot == OVERLAP_SLOT_NONE) return false;
+
+    // linear probing, so instead of leaving a tombstone, shift back any
+    // entries after the hole that would no longer be reachable
+    for (;;)
     {
-        col_bp_overlap_s *const overlap = &x_overlaps[i];
-        if (overlap->eid_a == col_ent_idx ||
-            overlap->eid_b == col_ent_idx)
+        set->slots[h] = OVERLAP_SLOT_NONE;
+
+        uint j = h;
+        uint next;
+        for (;;)
         {
-            uint pair = upair2u(overlap->eid_a, overlap->eid_b);
-            ENTITY_PAIR_CLEAR(x_contact_pairs, pair);
-            DYNARR_REMOVE(x_overlaps, x_overlap_count, i);
+            j = (j + 1) & OVERLAP_HASH_MASK;
+            next = set->slots[j];
+            if (next == OVERLAP_SLOT_NONE) goto shifted;
+
+            // distance from the entry's home bucket. if the hole is closer
+            // to home than the entry is, it can move into the hole.
+            uint home = overlap_hash(set->pool[next].pkey);
+            if (((j - home) & OVERLAP_HASH_MASK) >=
+                ((j - h) & OVERLAP_HASH_MASK))
+                break;
         }
+
+        set->slots[h] = (u16) next;
+        h = j;
     }
+    shifted:
+
+    // unlink it. the others stay in the order they were added in, since
+    // contacts are resolved in list order, and the results of simultaneous
+    // pushes depend on it.
+    col_bp_overlap_s *overlap = set->pool + slot;
+    if (overlap->prev != OVERLAP_SLOT_NONE)
+        set->pool[overlap->prev].next = overlap->next;
+    else
+        set->head = overlap->next;
+
+    if (overlap->next != OVERLAP_SLOT_NONE)
+        set->pool[overlap->next].prev = overlap->prev;
+    else
+        set->tail = overlap->prev;
+
+    overlap->next = set->free_head;
+    set->free_head = (u16) slot;
+    --set->count;
 
-    // remove y edge
-    for (int i = y_edge_count - 1; i >= 0; --i)
+    return true;
+}
+
+// remove both edges of an entity from an edge list in a single pass, keeping
+// the rest of the list in sorted order.
+static void remove_ent_edges(col_bp_edge_s *list, int *list_count,
+                             int col_ent_idx)
+{
+    int count = *list_count;
+    int j = 0;
+    for (int i = 0; i < count; ++i)
     {
-        if (y_edges[i].eid == col_ent_idx)
-            DYNARR_REMOVE(y_edges, y_edge_count, i);
+        if (list[i].eid == col_ent_idx) continue;
+        if (i != j) list[j] = list[i];
+        ++j;
     }
 
-    // remove y overlaps umm
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+    *list_count = j;
+}
+
+static void col_ent_removed(int col_ent_idx)
+{
+    LOG_DBG("col_ent_removed");
+
+    wake_around(col_ent_idx);
+
+    remove_ent_edges(x_edges, &x_edge_count, col_ent_idx);
+
+    // remove the entity's overlaps
+    for (uint i = x_overlaps.head; i != OVERLAP_SLOT_NONE;)
     {
-        uint pair = upair2u(col_ent_idx, i);
-        ENTITY_PAIR_CLEAR(y_contact_pairs, pair);
+        const col_bp_overlap_s *overlap = x_overlaps.pool + i;
+        i = overlap->next;
+
+        if (overlap->eid_a == col_ent_idx || overlap->eid_b == col_ent_idx)
+            overlap_set_remove(&x_overlaps, overlap->pkey);
     }
 }
 
@@ -253,8 +538,7 @@ static void col_ent_removed(int col_ent_idx)
 ARM_FUNC
 static void sort_edge_list(col_bp_edge_s *const list,
                            const int list_count,
-                           u8 contact_pairs[ENTITY_PAIR_SIZE],
-                           col_bp_overlap_s *overlaps, int *overlap_count)
+                           col_bp_overlap_set_s *overlaps)
 {   
     for (int i = 0; i < list_count - 1; ++i)
     {
@@ -280,36 +564,16 @@ static void sort_edge_list(col_bp_edge_s *const list,
             // R-L -> L-R (add overlap)
             if (edge1->left && !edge2->left)
             {
-                ENTITY_PAIR_SET(contact_pairs, pair_key);
-
-                if (overlaps)
-                {
-                    overlaps[(*overlap_count)++] = (col_bp_overlap_s)
-                    {
-                        .eid_a = eid1,
-                        .eid_b = eid2
-                    };
-                }
+                overlap_set_add(overlaps, eid1, eid2, pair_key);
             }
             // L-R -> R-L (remove overlap)
             else if (!edge1->left && edge2->left)
             {
-                ENTITY_PAIR_CLEAR(contact_pairs, pair_key);
-
-                if (overlaps)
+                // an overflowed set is missing overlaps anyway
+                if (!overlap_set_remove(overlaps, pair_key) &&
+                    !overlaps->overflow)
                 {
-                    int count = *overlap_count;
-                    for (int k = 0; k < count; ++k)
-                    {
-                        if ((overlaps[k].eid_a == eid1 && overlaps[k].eid_b == eid2) ||
-                            (overlaps[k].eid_a == eid2 && overlaps[k].eid_b == eid1))
-                        {
-                            DYNARR_REMOVE(overlaps, *overlap_count, k);
-                            goto overlap_found;
-                        }
-                    }
-                    LOG_ERR("overlap not found in list!");
-                    overlap_found:;
+                    LOG_ERR("overlap not found in set!");
                 }
             }
 
@@ -335,27 +599,14 @@ static void update_edge_lists(void)
             edge->pos = ent->pos.x + col->width;
     }
 
-    // sync y edges
-    for (int i = 0; i < y_edge_count; ++i)
-    {
-        col_bp_edge_s *edge = y_edges + i;
-        const entity_coldata_s *col = col_ent_map + edge->eid;
-        const entity_s *ent = col->ent;
-
-        if (edge->left)
-            edge->pos = ent->pos.y;
-        else
-            edge->pos = ent->pos.y + col->height;
-    }
-
-    // perform sweep and prune
-    sort_edge_list(x_edges, x_edge_count, x_contact_pairs, x_overlaps,
-                   &x_overlap_count);
-    sort_edge_list(y_edges, y_edge_count, y_contact_pairs, NULL, NULL);
+    // perform sweep and prune. this is only done on the x axis; the few
+    // pairs that overlap on x are checked on the y axis directly, which is
+    // cheaper than keeping a second sorted edge list and pair set around.
+    sort_edge_list(x_edges, x_edge_count, &x_overlaps);
 }
 
 // a body is anchored if:
-// 1. it is static (i.e. does not have ENTITY_FLAG_MOVING set)
+// 1. it is static (i.e. does not have ENTITY_FLAG_MOVING set, or is asleep)
 // 2. it has previously collided with an anchored object in the same
 //    direction.
 // this function only checks for condition #2.
@@ -367,99 +618,218 @@ static inline bool is_body_anchored(entity_coldata_s *col_ent, FIXED nx,
     return false;
 }
 
-ARM_FUNC NO_INLINE
-static void physics_substeps_collect_contacts(void)
+// ent_b is NULL for tiles
+static inline bool col_groups_match(const entity_s *ent_a,
+                                    const entity_s *ent_b)
 {
-    PROFILE_START();
+    uint col_group_a = (uint)ent_a->col.group;
+    uint col_mask_a = (uint)ent_a->col.mask;
 
-    update_edge_lists();
-    col_contact_count = 0;
+    uint col_group_b, col_mask_b;
+    if (ent_b)
+    {
+        col_group_b = (uint)ent_b->col.group;
+        col_mask_b = (uint)ent_b->col.mask;
+    }
+    else
+    {
+        col_group_b = COLGROUP_DEFAULT;
+        col_mask_b = COLGROUP_ALL;
+    }
 
-    // collect entity contacts
-    for (int i = 0; i < x_overlap_count; ++i)
+    return (col_group_b & col_mask_a) || (col_group_a & col_mask_b);
+}
+
+// narrow phase for a pair of bodies that overlap on the x axis. adds a
+// contact if they collide, and runs their ent_touch callbacks. returns false
+// if the contact list is full.
+static inline bool collect_ent_contact(entity_coldata_s *col_ent,
+                                       entity_coldata_s *entc2)
+{
+    if (col_contact_count >= MAX_CONTACT_COUNT)
     {
-        if (col_contact_count >= MAX_CONTACT_COUNT)
+        LOG_WRN("max contacts exceeded!");
+        return false;
+    }
+
+    // check if this X overlap between two entities also exists on the Y
+    // axis
+    {
+        const FIXED ya = col_ent->ent->pos.y;
+        const FIXED yb = entc2->ent->pos.y;
+        if (ya >= yb + entc2->height || yb >= ya + col_ent->height)
+            return true;
+    }
+
+    // a dynamic body running into a sleeping one wakes it up, along
+    // with the rest of its island. this has to happen before the swap
+    // below, since the sleeping body will no longer count as static.
+    if ((col_ent->ent->flags ^ entc2->ent->flags) & ENTITY_FLAG_SLEEPING)
+    {
+        entity_coldata_s *sleeper = col_ent;
+        entity_coldata_s *waker = entc2;
+        if (entc2->ent->flags & ENTITY_FLAG_SLEEPING)
         {
-            LOG_WRN("max contacts exceeded!");
-            return;
+            sleeper = entc2;
+            waker = col_ent;
         }
 
-        // check if this X overlap between two entities also exists on the Y
-        // axis
-        const col_bp_overlap_s *x_overlap = x_overlaps + i;
-        uint pkey = upair2u(x_overlap->eid_a, x_overlap->eid_b);
-        if (!ENTITY_PAIR_GET(y_contact_pairs, pkey)) continue;
-
-        entity_coldata_s *col_ent = col_ent_map + x_overlap->eid_a;
-        entity_coldata_s *entc2 = col_ent_map + x_overlap->eid_b;
+        const FIXED xs = sleeper->ent->pos.x;
+        const FIXED xw = waker->ent->pos.x;
 
-        // make sure that the second entity is the static one
-        if (entc2->ent->flags & ENTITY_FLAG_MOVING)
+        if (!body_is_static(waker->ent) &&
+            !((sleeper->ent->flags | waker->ent->flags) &
+              ENTITY_FLAG_QFREE) &&
+            !(waker->ent->col.flags & COL_FLAG_MONITOR_ONLY) &&
+            col_groups_match(waker->ent, sleeper->ent) &&
+            xs < xw + waker->width && xw < xs + sleeper->width)
         {
-            entity_coldata_s *temp;
-            SWAP3(col_ent, entc2, temp);
+            wake_island(sleeper->island);
         }
+    }
 
-        entity_s *entity = col_ent->ent;
-        entity_s *ent2 = entc2->ent;
+    // make sure that the second entity is the static one
+    if (!body_is_static(entc2->ent))
+    {
+        entity_coldata_s *temp;
+        SWAP3(col_ent, entc2, temp);
+    }
+
+    entity_s *entity = col_ent->ent;
+    entity_s *ent2 = entc2->ent;
+
+    // don't handle collision if one of the entities is queued to be
+    // freed
+    if ((entity->flags & ENTITY_FLAG_QFREE) ||
+        (ent2->flags & ENTITY_FLAG_QFREE))
+    {
+        return true;   
+    }
+
+    // if both entities are static objects, collision cannot happen
+    // between them.
+    if (body_is_static(entity) && body_is_static(ent2))
+        return true;
+
+    if (col_ent == entc2)
+    {
+        LOG_WRN("entity contact is with itself? how tf?");
+        return true;
+    }
+
+    // narrow-phase collision. also calculates penetration vector.
+    const FIXED hw0 = col_ent->half_width;
+    const FIXED hh0 = col_ent->half_height;
+    const FIXED hw1 = entc2->half_width;
+    const FIXED hh1 = entc2->half_height;
+    
+    col_overlap_res_s overlap_res =
+        rect_collision(entity->pos.x, entity->pos.y, hw0, hh0,
+                        ent2->pos.x, ent2->pos.y, hw1, hh1);
+
+    if (!overlap_res.overlap) return true;
+    if (overlap_res.ny <= 0 && ent2->col.flags & COL_FLAG_FLOOR_ONLY)
+        return true;
+    if (overlap_res.ny >= 0 && entity->col.flags & COL_FLAG_FLOOR_ONLY)
+        return true;
+
+    // add contact to contact list
+    col_contacts[col_contact_count] = (col_contact_s)
+    {
+        .nx = overlap_res.nx,
+        .ny = overlap_res.ny,
+        .pd = overlap_res.pd,
+        .ent_a = col_ent,
+        .ent_b = entc2,
+        .priority = !body_is_static(entity) || !body_is_static(ent2)
+    };
+    ++col_contact_count;
+
+    // the callbacks stop getting called once a body is asleep, so
+    // don't let either one fall asleep while this keeps happening
+    if (has_ent_touch(entity) || has_ent_touch(ent2))
+    {
+        col_ent->no_sleep = true;
+        entc2->no_sleep = true;
+    }
+
+    // run behavior callbacks
+    int nx_int = sgn3(overlap_res.nx);
+    int ny_int = sgn3(overlap_res.ny);
+
+    if (entity->behavior && entity->behavior->ent_touch)
+        entity->behavior->ent_touch(entity, ent2, nx_int, ny_int);
+    if (ent2->behavior && ent2->behavior->ent_touch)
+        ent2->behavior->ent_touch(ent2, entity, -nx_int, -ny_int);
+
+    return true;
+}
+
+ARM_FUNC NO_INLINE
+static void physics_substeps_collect_contacts(void)
+{
+    PROFILE_START();
+
+    update_edge_lists();
+    col_contact_count = 0;
 
-        // don't handle collision if one of the entities is queued to be
-        // freed
-        if ((entity->flags & ENTITY_FLAG_QFREE) ||
-            (ent2->flags & ENTITY_FLAG_QFREE))
+    // collect entity contacts
+    if (!x_overlaps.overflow)
+    {
+        for (uint i = x_overlaps.head; i != OVERLAP_SLOT_NONE;
+             i = x_overlaps.pool[i].next)
         {
-            continue;   
+            const col_bp_overlap_s *x_overlap = x_overlaps.pool + i;
+            if (!collect_ent_contact(col_ent_map + x_overlap->eid_a,
+                                     col_ent_map + x_overlap->eid_b))
+            {
+                return;
+            }
         }
+    }
+    else
+    {
+        // the overlap set ran out of room, so go through the sorted edges
+        // instead, keeping a list of the bodies whose left edge has been
+        // passed but not their right one. every body in it overlaps the next
+        // one that starts. the set is refilled along the way, and takes over
+        // again once everything fits.
+        overlap_set_clear(&x_overlaps);
 
-        // if both entities are static objects, collision cannot happen
-        // between them.
-        if (!(entity->flags & ENTITY_FLAG_MOVING) &&
-            !(ent2->flags & ENTITY_FLAG_MOVING))
-            continue;
+        u16 open[MAX_ENTITY_COUNT];
+        int open_count = 0;
 
-        if (col_ent == entc2)
+        for (int i = 0; i < x_edge_count; ++i)
         {
-            LOG_WRN("entity contact is with itself? how tf?");
-            continue;
-        }
+            const col_bp_edge_s *edge = x_edges + i;
+            const uint eid = edge->eid;
 
-        // narrow-phase collision. also calculates penetration vector.
-        const FIXED hw0 = col_ent->half_width;
-        const FIXED hh0 = col_ent->half_height;
-        const FIXED hw1 = entc2->half_width;
-        const FIXED hh1 = entc2->half_height;
-        
-        col_overlap_res_s overlap_res =
-            rect_collision(entity->pos.x, entity->pos.y, hw0, hh0,
-                            ent2->pos.x, ent2->pos.y, hw1, hh1);
+            if (!edge->left)
+            {
+                int k = 0;
+                while (k < open_count && open[k] != eid) ++k;
+                if (k == open_count) continue;
 
-        if (!overlap_res.overlap) continue;
-        if (overlap_res.ny <= 0 && ent2->col.flags & COL_FLAG_FLOOR_ONLY)
-            continue;
-        if (overlap_res.ny >= 0 && entity->col.flags & COL_FLAG_FLOOR_ONLY)
-            continue;
+                for (--open_count; k < open_count; ++k)
+                    open[k] = open[k + 1];
+                continue;
+            }
 
-        // add contact to contact list
-        col_contacts[col_contact_count] = (col_contact_s)
-        {
-            .nx = overlap_res.nx,
-            .ny = overlap_res.ny,
-            .pd = overlap_res.pd,
-            .ent_a = col_ent,
-            .ent_b = entc2,
-            .priority = (entity->flags & ENTITY_FLAG_MOVING) ||
-                        (ent2->flags & ENTITY_FLAG_MOVING)
-        };
-        ++col_contact_count;
-
-        // run behavior callbacks
-        int nx_int = sgn3(overlap_res.nx);
-        int ny_int = sgn3(overlap_res.ny);
-
-        if (entity->behavior && entity->behavior->ent_touch)
-            entity->behavior->ent_touch(entity, ent2, nx_int, ny_int);
-        if (ent2->behavior && ent2->behavior->ent_touch)
-            ent2->behavior->ent_touch(ent2, entity, -nx_int, -ny_int);
+            for (int k = 0; k < open_count; ++k)
+            {
+                overlap_set_add(&x_overlaps, eid, open[k],
+                                upair2u(eid, open[k]));
+                if (!collect_ent_contact(col_ent_map + eid,
+                                         col_ent_map + open[k]))
+                {
+                    // the rest of the overlaps didn't make it in
+                    x_overlaps.overflow = true;
+                    return;
+                }
+            }
+
+            open[open_count++] = (u16) eid;
+        }
     }
 
     PROFILE_END(detection_ent_t);
@@ -478,7 +848,7 @@ static void physics_substeps_collect_contacts(void)
         entity_coldata_s *const col_ent = col_ents[i];
         entity_s *entity = col_ent->ent;
 
-        if (!(entity->flags & ENTITY_FLAG_MOVING)) continue;
+        if (body_is_static(entity)) continue;
 
         // only calculate tile overlaps if this entity moved in the previous
         // iteration. (or, if it's the first iteration.)
@@ -517,39 +887,52 @@ static void physics_substeps_collect_contacts(void)
             if (er < 0) --min_x;
             if (eb < 0) --min_y;
 
-            // bool tile_col_found = false;
-            // FIXED final_nx = 0, final_ny = 0, final_pd = 0;
-            // int tx, ty;
+            // test the tile rows in spans of up to 32 tiles at once, using
+            // the solid bitmask. most rows under an entity don't have any
+            // solid tiles, so those are skipped with a single test.
             for (int y = min_y; y <= max_y; ++y)
             {
-                for (int x = min_x; x <= max_x; ++x)
+                for (int x0 = min_x; x0 <= max_x; x0 += 32)
                 {
-                    if (game_get_col_clamped(x, y) != 1)
-                        continue;
+                    int n = max_x - x0 + 1;
+                    if (n > 32) n = 32;
+
+                    u32 bits = game_get_solid_bits(x0, y, n);
+                    while (bits)
+                    {
+                        const int x = x0 + bit_ctz32(bits);
+                        bits &= bits - 1;
+
+                        if (col_contact_count >= MAX_CONTACT_COUNT)
+                        {
+                            LOG_WRN("max contacts exceeded!");
+                            return;
+                        }
 
-                    const FIXED tx = x * FIX_ONE * WORLD_TILE_SIZE;
-                    const FIXED ty = y * FIX_ONE * WORLD_TILE_SIZE;
+                        const FIXED tx = x * FIX_ONE * WORLD_TILE_SIZE;
+                        const FIXED ty = y * FIX_ONE * WORLD_TILE_SIZE;
 
-                    col_overlap_res_s overlap_res = 
-                        rect_collision(entity->pos.x, entity->pos.y,
-                                        col_half_w, col_half_h, tx, ty,
-                                        int2fx(WORLD_TILE_SIZE) / 2,
-                                        int2fx(WORLD_TILE_SIZE) / 2);
-                    
-                    if (!overlap_res.overlap) continue;
+                        col_overlap_res_s overlap_res = 
+                            rect_collision(entity->pos.x, entity->pos.y,
+                                           col_half_w, col_half_h, tx, ty,
+                                           int2fx(WORLD_TILE_SIZE) / 2,
+                                           int2fx(WORLD_TILE_SIZE) / 2);
+                        
+                        if (!overlap_res.overlap) continue;
 
-                    col_contacts[col_contact_count] = (col_contact_s)
-                    {
-                        .nx = overlap_res.nx,
-                        .ny = overlap_res.ny,
-                        .pd = overlap_res.pd,
-                        .ent_a = col_ent,
-                        .ent_b = NULL,
-                        .priority = 1,
-                        .tx = tx,
-                        .ty = ty,
-                    };
-                    ++col_contact_count;
+                        col_contacts[col_contact_count] = (col_contact_s)
+                        {
+                            .nx = overlap_res.nx,
+                            .ny = overlap_res.ny,
+                            .pd = overlap_res.pd,
+                            .ent_a = col_ent,
+                            .ent_b = NULL,
+                            .priority = 1,
+                            .tx = (s16) x,
+                            .ty = (s16) y,
+                        };
+                        ++col_contact_count;
+                    }
                 }
             }
         }
@@ -580,28 +963,237 @@ static void physics_substeps_collect_contacts(void)
     }
 }
 
+// contact warm-starting:
+// a body resting on the ground, or on a stack of other bodies, falls into its
+// support every substep and has to be pushed back out. in a stack that takes
+// one iteration per body, since a body only counts as anchored once the one
+// below it has been resolved, so tall stacks run out of iterations and never
+// settle.
+//
+// so every anchored contact that gets resolved is remembered. at the start of
+// the next substep, before anything moves, the contacts that would happen
+// again are resolved up front, in the same order as before: the velocity into
+// the support is removed and the anchor state is restored. the bodies then
+// just don't fall into their supports, and a settled stack needs a single
+// iteration.
+//
+// contacts between two entities where either has an ent_touch callback are
+// not warm-started, since the callback would stop getting called once the
+// bodies no longer overlap.
+
+static void warm_contact_record(const entity_coldata_s *mover,
+                                const entity_coldata_s *support,
+                                FIXED nx, FIXED ny, int tx, int ty)
+{
+    const int list = warm_contact_cur;
+    if (warm_contact_count[list] >= WARM_CONTACT_MAX_COUNT) return;
+
+    if (support && (has_ent_touch(mover->ent) || has_ent_touch(support->ent)))
+        return;
+
+    warm_contacts[list][warm_contact_count[list]++] = (col_warm_contact_s)
+    {
+        .mover = (u16)(mover - col_ent_map),
+        .support = support ? (u16)(support - col_ent_map) : WARM_SUPPORT_TILE,
+        .nx = nx,
+        .ny = ny,
+        .tx = (s16) tx,
+        .ty = (s16) ty
+    };
+}
+
+// returns true if the warm contact still exists, i.e. the mover would
+// collide with its support in the same direction after moving this substep.
+static bool warm_contact_valid(const col_warm_contact_s *wc,
+                               entity_coldata_s *mover,
+                               entity_coldata_s *support, FIXED vel_mult)
+{
+    const entity_s *ent = mover->ent;
+    const entity_s *sup = support ? support->ent : NULL;
+
+    if (body_is_static(ent)) return false;
+    if (ent->flags & ENTITY_FLAG_QFREE) return false;
+    if (ent->col.flags & COL_FLAG_MONITOR_ONLY) return false;
+    if (!col_groups_match(ent, sup)) return false;
+
+    const FIXED mx = ent->pos.x + fxmul(ent->vel.x, vel_mult);
+    const FIXED my = ent->pos.y + fxmul(ent->vel.y, vel_mult);
+    col_overlap_res_s res;
+
+    if (sup)
+    {
+        if (sup->flags & ENTITY_FLAG_QFREE) return false;
+        if (sup->col.flags & COL_FLAG_MONITOR_ONLY) return false;
+        if (has_ent_touch(ent) || has_ent_touch(sup)) return false;
+
+        // the support has to be anchored in this direction already. moving
+        // supports have had their own warm contacts replayed by now.
+        bool anchored = body_is_static(sup) ||
+                        is_body_anchored(support, -wc->nx, -wc->ny);
+        if (!anchored) return false;
+
+        FIXED sx = sup->pos.x;
+        FIXED sy = sup->pos.y;
+        if (!body_is_static(sup))
+        {
+            sx += fxmul(sup->vel.x, vel_mult);
+            sy += fxmul(sup->vel.y, vel_mult);
+        }
+
+        res = rect_collision(mx, my, mover->half_width, mover->half_height,
+                             sx, sy, support->half_width,
+                             support->half_height);
+
+        // same one-way checks as in physics_substeps_collect_contacts
+        if (res.ny <= 0 && sup->col.flags & COL_FLAG_FLOOR_ONLY) return false;
+        if (res.ny >= 0 && ent->col.flags & COL_FLAG_FLOOR_ONLY) return false;
+    }
+    else
+    {
+        if (!(ent->col.mask & COLGROUP_DEFAULT)) return false;
+
+        if (!game_get_solid_bits(wc->tx, wc->ty, 1)) return false;
+
+        const FIXED tx = wc->tx * FIX_ONE * WORLD_TILE_SIZE;
+        const FIXED ty = wc->ty * FIX_ONE * WORLD_TILE_SIZE;
+        res = rect_collision(mx, my, mover->half_width, mover->half_height,
+                             tx, ty,
+                             int2fx(WORLD_TILE_SIZE) / 2,
+                             int2fx(WORLD_TILE_SIZE) / 2);
+    }
+
+    return res.overlap && res.nx == wc->nx && res.ny == wc->ny;
+}
+
+static inline void warm_contact_anchor(entity_coldata_s *mover, FIXED nx,
+                                       FIXED ny)
+{
+    if (nx != 0) mover->x_anchor = sgn(-nx);
+    if (ny != 0) mover->y_anchor = sgn(-ny);
+}
+
+// sets the actor flags for the contacts replayed at the start of the substep.
+// this waits until after the first contact pass, which is when they'd have
+// been set if the contacts had been resolved normally. an ent_touch callback
+// can stop an entity from being an actor (the player dying, say), and it
+// shouldn't be left grounded by a contact that was replayed before that.
+static void warm_contacts_set_actor_flags(void)
+{
+    const int list = warm_contact_cur;
+
+    for (int i = 0; i < warm_contact_count[list]; ++i)
+    {
+        const col_warm_contact_s *wc = warm_contacts[list] + i;
+        entity_s *ent = col_ent_map[wc->mover].ent;
+        if (!ent || !(ent->flags & ENTITY_FLAG_ACTOR)) continue;
+
+        if (wc->ny > 0)
+            ent->actor.flags |= ACTOR_FLAG_GROUNDED;
+
+        if (wc->nx != 0)
+            ent->actor.flags |= ACTOR_FLAG_WALL;
+    }
+}
+
+static void warm_start_contacts(FIXED vel_mult)
+{
+    const int prev = warm_contact_cur;
+    warm_contact_cur ^= 1;
+    warm_contact_count[warm_contact_cur] = 0;
+
+    for (int i = 0; i < warm_contact_count[prev]; ++i)
+    {
+        const col_warm_contact_s *wc = warm_contacts[prev] + i;
+
+        entity_coldata_s *mover = col_ent_map + wc->mover;
+        entity_coldata_s *support = NULL;
+        if (!mover->ent) continue;
+
+        if (wc->support != WARM_SUPPORT_TILE)
+        {
+            support = col_ent_map + wc->support;
+            if (!support->ent) continue;
+        }
+
+        // sleeping bodies don't fall into their supports, so their contacts
+        // can't be tested like the others. they're kept as they are instead,
+        // so that a body woken up in the middle of a substep is still anchored
+        // like it would have been had it stayed awake.
+        if (mover->ent->flags & ENTITY_FLAG_SLEEPING)
+        {
+            warm_contact_anchor(mover, wc->nx, wc->ny);
+            warm_contact_record(mover, support, wc->nx, wc->ny, wc->tx,
+                                wc->ty);
+            continue;
+        }
+
+        if (!warm_contact_valid(wc, mover, support, vel_mult)) continue;
+
+        entity_s *ent = mover->ent;
+        FIXED rel_vx = ent->vel.x;
+        FIXED rel_vy = ent->vel.y;
+        if (support)
+        {
+            rel_vx -= support->ent->vel.x;
+            rel_vy -= support->ent->vel.y;
+        }
+
+        const FIXED nx = wc->nx;
+        const FIXED ny = wc->ny;
+        FIXED vdot = fxmul(nx, rel_vx) + fxmul(ny, rel_vy);
+        if (vdot <= 0) continue;
+
+        // same as an anchored collision in physics_substep, minus the
+        // position correction, since nothing has moved yet.
+        ent->vel.x = ent->vel.x - fxmul(nx, vdot);
+        ent->vel.y = ent->vel.y - fxmul(ny, vdot);
+        warm_contact_anchor(mover, nx, ny);
+
+        warm_contact_record(mover, support, nx, ny, wc->tx, wc->ty);
+        island_link(mover, support);
+
+        #ifdef PHYS_PROFILE
+        ++game_physics_profile.warm_contact_count;
+        #endif
+    }
+}
+
+static void warm_contacts_clear(void)
+{
+    warm_contact_count[0] = 0;
+    warm_contact_count[1] = 0;
+}
+
 static bool physics_substep(FIXED vel_mult)
 {
     PROFILE_START();
 
-    // first move all entities. also reset substep-local state.
+    // reset substep-local state
     for (int i = 0; i < col_ent_count; ++i)
     {
         entity_coldata_s *const col_ent = col_ents[i];
         entity_s *entity = col_ent->ent;
 
-        if (entity->flags & ENTITY_FLAG_MOVING)
+        col_ent->dirty = true;
+        col_ent->head_bump = entity->col.flags & COL_FLAG_HEAD_BUMP;
+        col_ent->x_anchor = 0;
+        col_ent->y_anchor = 0;
+    }
+
+    warm_start_contacts(vel_mult);
+
+    // then move all entities
+    for (int i = 0; i < col_ent_count; ++i)
+    {
+        entity_s *entity = col_ents[i]->ent;
+
+        if (!body_is_static(entity))
         {
             FIXED s_vx = fxmul(entity->vel.x, vel_mult);
             FIXED s_vy = fxmul(entity->vel.y, vel_mult);
             entity->pos.x += s_vx;
             entity->pos.y += s_vy;
         }
-
-        col_ent->dirty = true;
-        col_ent->head_bump = entity->col.flags & COL_FLAG_HEAD_BUMP;
-        col_ent->x_anchor = 0;
-        col_ent->y_anchor = 0;
     }
 
     PROFILE_END(move_t);
@@ -618,6 +1210,11 @@ static bool physics_substep(FIXED vel_mult)
         }
 
         physics_substeps_collect_contacts();
+        if (subsubstep == 1) warm_contacts_set_actor_flags();
+
+        #ifdef PHYS_PROFILE
+        game_physics_profile.contact_count += col_contact_count;
+        #endif
 
         PROFILE_START();
         bool break_substep = true;
@@ -647,8 +1244,8 @@ static bool physics_substep(FIXED vel_mult)
             // no more overlap, just skip the contact.
             if (col_ent_a->dirty && !col_ent_b)
             {
-                const FIXED tx = contact->tx;
-                const FIXED ty = contact->ty;
+                const FIXED tx = contact->tx * FIX_ONE * WORLD_TILE_SIZE;
+                const FIXED ty = contact->ty * FIX_ONE * WORLD_TILE_SIZE;
 
                 col_overlap_res_s test_overlap =
                     rect_collision(ent_a->pos.x, ent_a->pos.y,
@@ -697,28 +1294,14 @@ static bool physics_substep(FIXED vel_mult)
             
             if (vdot < 0) continue;
 
-            uint col_group_a = (uint)ent_a->col.group;
-            uint col_mask_a = (uint)ent_a->col.mask;
-
             // check collision groups
-            uint col_group_b, col_mask_b;
-            if (ent_b)
-            {
-                col_group_b = (uint)ent_b->col.group;
-                col_mask_b = (uint)ent_b->col.mask;
-            }
-            else
-            {
-                col_group_b = COLGROUP_DEFAULT;
-                col_mask_b = COLGROUP_ALL;
-            }
-
-            if (!(col_group_b & col_mask_a) && !(col_group_a & col_mask_b))
+            if (!col_groups_match(ent_a, ent_b))
                 continue;
 
             // check if this is a collision with an anchored body.
             // a body is anchored if:
-            // 1. it is static (i.e. does not have ENTITY_FLAG_MOVING set)
+            // 1. it is static (i.e. does not have ENTITY_FLAG_MOVING set,
+            //    or is asleep)
             // 2. it has previously collided with an anchored object in the same
             //    direction.
             bool anchor_a = false;
@@ -726,7 +1309,7 @@ static bool physics_substep(FIXED vel_mult)
             if (col_ent_b)
             {
                 anchor_a = is_body_anchored(col_ent_a, nx, ny);
-                anchor_b = !(ent_b->flags & ENTITY_FLAG_MOVING) ||
+                anchor_b = body_is_static(ent_b) ||
                            is_body_anchored(col_ent_b, -nx, -ny);
             }
 
@@ -737,7 +1320,7 @@ static bool physics_substep(FIXED vel_mult)
             // }
             // else
             // {
-            //     LOG_DBG("A(%i) vs Tile(%i, %i)", ent_a - g_game.entities, (int) contact->tx / (FIX_ONE * WORLD_TILE_SIZE), (int) contact->ty / (FIX_ONE * WORLD_TILE_SIZE));
+            //     LOG_DBG("A(%i) vs Tile(%i, %i)", ent_a - g_game.entities, (int) contact->tx, (int) contact->ty);
             //     LOG_DBG("%i,%i", nx, ny);
             // }
             
@@ -748,17 +1331,20 @@ static bool physics_substep(FIXED vel_mult)
 
                 entity_s *ent;
                 entity_coldata_s *ce;
+                entity_coldata_s *support;
 
                 // we only want to modify the entity that is not anchored.
                 if (anchor_b)
                 {
                     ent = ent_a;
                     ce = col_ent_a;
+                    support = col_ent_b;
                 }
                 else
                 {
                     ent = ent_b;
                     ce = col_ent_b;
+                    support = col_ent_a;
                     nx = -nx;
                     ny = -ny;
                 }
@@ -783,6 +1369,10 @@ static bool physics_substep(FIXED vel_mult)
 
                 if (nx != 0)
                     ent->actor.flags |= ACTOR_FLAG_WALL;
+
+                warm_contact_record(ce, support, nx, ny, contact->tx,
+                                    contact->ty);
+                island_link(ce, support);
             }
             else
             {
@@ -792,6 +1382,7 @@ static bool physics_substep(FIXED vel_mult)
                 // recalculated for this entity on the next iteration.
                 col_ent_a->dirty = true;
                 col_ent_b->dirty = true;
+                island_link(col_ent_a, col_ent_b);
 
                 FIXED inv_mass1 = col_ent_a->inv_mass;
                 FIXED inv_mass2 = col_ent_b->inv_mass;
@@ -862,8 +1453,11 @@ static bool physics_substep(FIXED vel_mult)
     }
 
     #ifdef PHYS_PROFILE
+    game_physics_profile.iteration_count += subsubstep;
+    #ifndef PHYS_PROFILE_QUIET
     LOG_DBG("ITERATION COUNT: %i", subsubstep);
     #endif
+    #endif
 
     bool no_movement = true;
 
@@ -880,6 +1474,83 @@ static bool physics_substep(FIXED vel_mult)
     return no_movement;
 }
 
+// puts an island to sleep once all of its bodies have been at rest for
+// PHYS_SLEEP_FRAMES frames in a row. sleeping bodies are skipped by the move
+// loop and tile detection, and act as static bodies for everything else.
+//
+// actors never sleep, since they're driven by their behaviors and input.
+// an island with an actor in it therefore never sleeps either.
+static void update_sleep(void)
+{
+    for (int i = 0; i < col_ent_count; ++i)
+    {
+        entity_coldata_s *const col_ent = col_ents[i];
+        entity_s *ent = col_ent->ent;
+        if (ent->flags & ENTITY_FLAG_SLEEPING) continue;
+
+        island_still[col_ent - col_ent_map] = UINT8_MAX;
+
+        bool can_sleep = !(ent->flags & (ENTITY_FLAG_ACTOR |
+                                         ENTITY_FLAG_QFREE)) &&
+                         !(ent->col.flags & COL_FLAG_MONITOR_ONLY) &&
+                         !has_ent_touch(ent) && !col_ent->no_sleep;
+
+        bool at_rest = ent->vel.x == 0 && ent->vel.y == 0 &&
+                       ent->pos.x == col_ent->sleep_x &&
+                       ent->pos.y == col_ent->sleep_y;
+
+        if (can_sleep && at_rest)
+        {
+            if (col_ent->still_frames < UINT8_MAX)
+                ++col_ent->still_frames;
+        }
+        else
+        {
+            col_ent->still_frames = 0;
+        }
+    }
+
+    // find the least rested body of each island
+    for (int i = 0; i < col_ent_count; ++i)
+    {
+        entity_coldata_s *const col_ent = col_ents[i];
+        if (body_is_static(col_ent->ent)) continue;
+
+        int root = island_find(col_ent - col_ent_map);
+        if (col_ent->still_frames < island_still[root])
+            island_still[root] = col_ent->still_frames;
+    }
+
+    #ifdef PHYS_PROFILE
+    u32 sleeping_count = 0;
+    #endif
+
+    for (int i = 0; i < col_ent_count; ++i)
+    {
+        entity_coldata_s *const col_ent = col_ents[i];
+        entity_s *ent = col_ent->ent;
+
+        if (!body_is_static(ent))
+        {
+            int root = island_find(col_ent - col_ent_map);
+            if (island_still[root] < PHYS_SLEEP_FRAMES) continue;
+
+            // the root is part of the island, and it's asleep now too, so
+            // no other sleeping island can have the same label.
+            ent->flags |= ENTITY_FLAG_SLEEPING;
+            col_ent->island = (u16) root;
+        }
+
+        #ifdef PHYS_PROFILE
+        if (ent->flags & ENTITY_FLAG_SLEEPING) ++sleeping_count;
+        #endif
+    }
+
+    #ifdef PHYS_PROFILE
+    game_physics_profile.sleeping_count = sleeping_count;
+    #endif
+}
+
 #pragma endregion entity physics
 
 
@@ -893,173 +1564,223 @@ static bool physics_substep(FIXED vel_mult)
 //------------------------------------------------------------------------------
 #pragma region projectile physics
 
-// in world units (8 units per tile)
-#define PARTGRID_CEL_W 64
-#define PARTGRID_CEL_H 64
-#define PARTGRID_COLS  8
-#define PARTGRID_ROWS  8
-#define PARTGRID_NODE_POOL_SIZE 128
+// the partition grid is sized to the room when it loads. cells start out at
+// 64x64 world units (8 units per tile), and get doubled in size until the
+// whole room fits in PARTGRID_MAX_CELLS.
+#define PARTGRID_BASE_CEL_SHIFT 6
+#define PARTGRID_MAX_CELLS 128
 
-typedef struct partgrid_node
-{
-    projectile_s *projectile;
+// cell ranges are stored in a u8
+_Static_assert(MAX_PROJECTILE_COUNT <= UINT8_MAX,
+               "MAX_PROJECTILE_COUNT too large for partgrid");
 
-    // if active (i.e. projectile != NULL), this points to the next node
-    // in the partition cell linked list. if inactive, this instead points to
-    // the next unallocated node in the pool.
-    union
-    {
-        struct partgrid_node *next;
-        struct partgrid_node *next_free;
-    };
-} partgrid_node_s;
+static int partgrid_cols = 1;
+static int partgrid_rows = 1;
+static int partgrid_cel_shift = PARTGRID_BASE_CEL_SHIFT;
 
-typedef partgrid_node_s *part_cell_t;
+// the grid is rebuilt with a counting sort every time projectiles are moved.
+// the projectiles in cell c are partgrid_projs[partgrid_cell_start[c]] up
+// to (but not including) partgrid_projs[partgrid_cell_start[c + 1]].
+static u8 partgrid_cell_start[PARTGRID_MAX_CELLS + 1];
+static u8 partgrid_projs[MAX_PROJECTILE_COUNT];
 
-typedef struct proj_part_data
+// cell index of each projectile, or -1 if it's not in the grid
+static s16 proj_cells[MAX_PROJECTILE_COUNT];
+
+// the segment each projectile moved along this frame, ending at its current
+// position. it's what gets tested against entities.
+typedef struct proj_sweep
 {
-    part_cell_t *part_cell;
+    FIXED dx, dy;
+
+    // the first entity along the segment, or -1. hit_t is where the segment
+    // enters it.
+    FIXED hit_t;
+    s16 hit_ent;
 }
-proj_part_data_s;
+proj_sweep_s;
+
+static proj_sweep_s proj_sweeps[MAX_PROJECTILE_COUNT];
 
-static proj_part_data_s proj_data[MAX_PROJECTILE_COUNT];
-static partgrid_node_s partgrid_node_pool[PARTGRID_NODE_POOL_SIZE];
-static partgrid_node_s *partgrid_node_pool_ffree; // first free
-static part_cell_t partgrid[PARTGRID_ROWS][PARTGRID_COLS];
+// projectiles that ran into a wall this frame
+static int proj_wall_hit_count;
+static u8 proj_wall_hits[MAX_PROJECTILE_COUNT];
 
+// projectiles that hit an entity this frame, in active list order
+static int proj_ent_hit_count;
+static u8 proj_ent_hits[MAX_PROJECTILE_COUNT];
 
 
 
 
 
 
-static partgrid_node_s* partgrid_node_alloc(projectile_s *proj)
+
+static void partgrid_resize(int room_w, int room_h)
 {
-    partgrid_node_s *node = partgrid_node_pool_ffree;
-    if (!node)
+    // room size in world units
+    const int w = room_w * WORLD_TILE_SIZE;
+    const int h = room_h * WORLD_TILE_SIZE;
+
+    int shift = PARTGRID_BASE_CEL_SHIFT;
+    int cols, rows;
+    for (;; ++shift)
     {
-        LOG_ERR("partgrid_node_pool full!");
-        return NULL;
+        cols = CEIL_DIV(w, 1 << shift);
+        rows = CEIL_DIV(h, 1 << shift);
+        if (cols * rows <= PARTGRID_MAX_CELLS) break;
     }
 
-    partgrid_node_pool_ffree = node->next_free;
+    if (cols < 1) cols = 1;
+    if (rows < 1) rows = 1;
 
-    *node = (partgrid_node_s)
-    {
-        .projectile = proj,
-    };
-
-    return node;
+    partgrid_cols = cols;
+    partgrid_rows = rows;
+    partgrid_cel_shift = shift;
+    
+    LOG_DBG("partgrid: %ix%i, cell size %i", cols, rows, 1 << shift);
 }
 
-static void partgrid_node_free(partgrid_node_s *node)
+// returns the range of grid cells that the given world-space interval
+// overlaps, clamped to the grid.
+static inline void partgrid_cell_range(FIXED min, FIXED max, int count,
+                                       int *out_min, int *out_max)
 {
-    node->projectile = NULL;
-    node->next_free = partgrid_node_pool_ffree;
-    partgrid_node_pool_ffree = node;
+    // arithmetic shift rounds towards negative infinity, so negative
+    // positions end up as negative cell indices and get clamped to 0.
+    const int shift = partgrid_cel_shift + FIX_SHIFT;
+    *out_min = iclamp(min >> shift, 0, count - 1);
+    *out_max = iclamp(max >> shift, 0, count - 1);
 }
 
-static partgrid_node_s* partgrid_cell_remove(partgrid_node_s **cell,
-                                             const projectile_s *proj)
+// clips the segment [t0, t1] (in FIX_ONE units) to where it's strictly
+// between lo and hi on one axis
+static inline bool clip_segment_axis(FIXED p, FIXED d, FIXED lo, FIXED hi,
+                                     FIXED *t0, FIXED *t1)
 {
-    if (!(*cell)) return NULL;
+    if (d == 0) return p > lo && p < hi;
 
-    if ((*cell)->projectile == proj)
+    FIXED ta = fxdiv(lo - p, d);
+    FIXED tb = fxdiv(hi - p, d);
+    if (ta > tb)
     {
-        partgrid_node_s *node = *cell;
-        *cell = node->next;
-        return node;
+        FIXED tmp;
+        SWAP3(ta, tb, tmp);
     }
 
-    partgrid_node_s *node = *cell;
-    partgrid_node_s *next = node->next;
-    while (next)
-    {
-        if (next->projectile == proj)
-        {
-            node->next = next->next;
-            next->next = NULL;
-            return next;
-        }
-
-        node = next;
-        next = next->next;
-    }
-
-    return NULL;
+    if (ta > *t0) *t0 = ta;
+    if (tb < *t1) *t1 = tb;
+    return *t0 < *t1;
 }
 
-static void partgrid_cell_insert(partgrid_node_s **cell,
-                                 partgrid_node_s *new_node)
+// does the segment from (x0, y0) to (x0 + dx, y0 + dy) go through the inside
+// of the given box? for a segment with no length, this is the same as testing
+// the point. out_t0 is set to where the segment enters the box, or 0 if it
+// starts inside.
+static bool segment_hits_box(FIXED x0, FIXED y0, FIXED dx, FIXED dy,
+                             FIXED l, FIXED t, FIXED r, FIXED b,
+                             FIXED *out_t0)
 {
-    new_node->next = *cell;
-    *cell = new_node;
+    FIXED t0 = 0;
+    FIXED t1 = FIX_ONE;
+
+    if (!clip_segment_axis(x0, dx, l, r, &t0, &t1)) return false;
+    if (!clip_segment_axis(y0, dy, t, b, &t0, &t1)) return false;
+
+    *out_t0 = t0;
+    return true;
 }
 
 ARM_FUNC NO_INLINE
-static void game_physics_move_projs(FIXED vel_mult)
+static void game_physics_move_projs(void)
 {
-    for (uint i = 0; i < MAX_PROJECTILE_COUNT; ++i)
-    {
-        projectile_s *proj = g_game.projectiles + i;
-        proj_part_data_s *pdata = proj_data + i;
-        if (!IS_PROJ_ACTIVE(proj) || (proj->flags & PROJ_FLAG_QFREE)) continue;
+    const int cell_count = partgrid_cols * partgrid_rows;
+    const int shift = partgrid_cel_shift + FIX_SHIFT;
+
+    // the longest distance any projectile moved on either axis. entities
+    // search this much further out in the grid, since projectiles are put in
+    // the cell they ended up in.
+    FIXED max_step = 0;
 
-        proj->px += fxmul(proj->vx, vel_mult);
-        proj->py += fxmul(proj->vy, vel_mult);
+    for (int i = 0; i < cell_count; ++i)
+        partgrid_cell_start[i] = 0;
 
-        // if projectile touches a wall, Destroy it.
-        int tx = proj->px / (WORLD_TILE_SIZE * FIX_SCALE);
-        int ty = proj->py / (WORLD_TILE_SIZE * FIX_SCALE);
-        if (tx < 0) --tx;
-        if (ty < 0) --ty;
+    proj_wall_hit_count = 0;
 
-        int map_col = game_get_col_clamped(tx, ty);
-        if (map_col == 1 || map_col == 2)
+    // proj_touch callbacks can spawn projectiles, so keep the count from
+    // before. new ones will be moved next frame.
+    const int proj_count = g_game.active_proj_count;
+
+    for (int k = 0; k < proj_count; ++k)
+    {
+        const int i = g_game.active_projs[k];
+        projectile_s *proj = g_game.projectiles + i;
+        proj_cells[i] = -1;
+        proj_sweeps[i].hit_ent = -1;
+        if (proj->flags & PROJ_FLAG_QFREE) continue;
+
+        // if projectile touches a wall, Destroy it. but only after entity
+        // collision, so that it can still hit something on the way there.
+        const FIXED x0 = proj->px;
+        const FIXED y0 = proj->py;
+        FIXED x1 = x0 + proj->vx;
+        FIXED y1 = y0 + proj->vy;
+
+        proj_sweep_s *sweep = proj_sweeps + i;
+        query_ray_hit_s hit;
+        if (game_query_ray(x0, y0, x1, y1, QUERY_TILE_SOLID | QUERY_TILE_WATER,
+                           &hit))
         {
-            // it was Destroyed.
-            projectile_queue_free(proj);
-            continue;
+            x1 = hit.x;
+            y1 = hit.y;
+            proj_wall_hits[proj_wall_hit_count++] = (u8) i;
         }
 
-        int new_px = proj->px / (FIX_ONE * PARTGRID_CEL_W);
-        int new_py = proj->py / (FIX_ONE * PARTGRID_CEL_H);
+        sweep->dx = x1 - x0;
+        sweep->dy = y1 - y0;
 
-        // clamp position to partition grid
-        if      (new_px < 0)              new_px = 0;
-        else if (new_px >= PARTGRID_COLS) new_px = PARTGRID_COLS - 1;
+        proj->px = x1;
+        proj->py = y1;
+
+        FIXED step = max(abs(sweep->dx), abs(sweep->dy));
+        if (step > max_step) max_step = step;
 
-        if      (new_py < 0)              new_py = 0;
-        else if (new_py >= PARTGRID_ROWS) new_py = PARTGRID_ROWS - 1;
+        // clamp position to partition grid
+        int cx = iclamp(proj->px >> shift, 0, partgrid_cols - 1);
+        int cy = iclamp(proj->py >> shift, 0, partgrid_rows - 1);
         
-        // location in partition grid changed?
-        part_cell_t *new_part_cell = &partgrid[new_py][new_px];
-        if (pdata->part_cell != new_part_cell)
-        {
-            // LOG_DBG("location in partition grid changed");
+        int cell = cy * partgrid_cols + cx;
+        proj_cells[i] = (s16) cell;
+        ++partgrid_cell_start[cell];
+    }
 
-            // remove from linked list of old cell
-            partgrid_node_s *node = pdata->part_cell
-                ? partgrid_cell_remove(pdata->part_cell, proj)
-                : NULL;
-            if (!node)
-            {
-                // LOG_DBG("old partition cell had no data");
-                node = partgrid_node_alloc(proj);
-                if (!node) DBG_CRASH();
-            }
+    // turn the cell counts into end offsets...
+    int sum = 0;
+    for (int i = 0; i < cell_count; ++i)
+    {
+        sum += partgrid_cell_start[i];
+        partgrid_cell_start[i] = (u8) sum;
+    }
+    partgrid_cell_start[cell_count] = (u8) sum;
 
-            // move node to new cell (or create a new node if not exists)
-            partgrid_cell_insert(new_part_cell, node);
-            pdata->part_cell = new_part_cell;
-        }
+    // ...then scatter projectiles into their cells. each cell offset is
+    // decremented as it's filled, so at the end it will point at the start
+    // of the cell. going backwards keeps each cell sorted by index.
+    for (int k = proj_count - 1; k >= 0; --k)
+    {
+        const int i = g_game.active_projs[k];
+        int cell = proj_cells[i];
+        if (cell < 0) continue;
+        partgrid_projs[--partgrid_cell_start[cell]] = (u8) i;
     }
 
-    // projectile/entity collision detection
+    // projectile/entity collision detection. a projectile only touches one
+    // entity per frame, so first find the nearest one along each segment.
     for (int i = 0; i < col_ent_count; ++i)
     {
         entity_coldata_s *const col_ent = col_ents[i];
         entity_s *entity = col_ent->ent;
+        const int ent_idx = col_ent - col_ent_map;
 
         if (!(entity->col.mask & COLGROUP_PROJECTILE)) continue;
         if (entity->col.flags & COL_FLAG_MONITOR_ONLY) continue;
@@ -1072,63 +1793,102 @@ static void game_physics_move_projs(FIXED vel_mult)
         const int er = (entity->pos.x + col_w);
         const int eb = (entity->pos.y + col_h);
 
-        int min_px = el / (FIX_ONE * PARTGRID_CEL_W);
-        int min_py = et / (FIX_ONE * PARTGRID_CEL_H);
-        int max_px = er / (FIX_ONE * PARTGRID_CEL_W);
-        int max_py = eb / (FIX_ONE * PARTGRID_CEL_H);
-
-        // clamp bounds to partition grid
-        if      (min_px < 0)              min_px = 0;
-        else if (min_px >= PARTGRID_COLS) min_px = PARTGRID_COLS - 1;
-        if      (max_px < 0)              max_px = 0;
-        else if (max_px >= PARTGRID_COLS) max_px = PARTGRID_COLS - 1;
-
-        if      (min_py < 0)              min_py = 0;
-        else if (min_py >= PARTGRID_ROWS) min_py = PARTGRID_ROWS - 1;
-        if      (max_py < 0)              max_py = 0;
-        else if (max_py >= PARTGRID_ROWS) max_py = PARTGRID_ROWS - 1;
+        int min_px, max_px, min_py, max_py;
+        partgrid_cell_range(el - max_step, er + max_step, partgrid_cols,
+                            &min_px, &max_px);
+        partgrid_cell_range(et - max_step, eb + max_step, partgrid_rows,
+                            &min_py, &max_py);
 
         for (int y = min_py; y <= max_py; ++y)
         {
             for (int x = min_px; x <= max_px; ++x)
             {
-                // traverse linked list
-                for (partgrid_node_s *node = partgrid[y][x]; node;
-                    node = node->next)
-                {
-                    projectile_s *proj = node->projectile;
+                const int cell = y * partgrid_cols + x;
+                const int end = partgrid_cell_start[cell + 1];
 
-                    if (proj->flags & PROJ_FLAG_QFREE) continue;
-
-                    FIXED px = proj->px;
-                    FIXED py = proj->py;
-
-                    if (!(px > el && px < er && py > et && py < eb))
-                        continue;
+                for (int k = partgrid_cell_start[cell]; k < end; ++k)
+                {
+                    const int proj_idx = partgrid_projs[k];
+                    const projectile_s *proj = g_game.projectiles + proj_idx;
+                    proj_sweep_s *sweep = proj_sweeps + proj_idx;
 
-                    if (proj->did_touch_this_frame) continue;
-                    proj->did_touch_this_frame = true;
+                    const FIXED x0 = proj->px - sweep->dx;
+                    const FIXED y0 = proj->py - sweep->dy;
 
-                    // if (!(entity->flags & ENTITY_FLAG_MOVING))
-                    //     LOG_DBG("Proc");
-                    
-                    bool keep;
-                    if (entity->behavior &&
-                        entity->behavior->proj_touch)
+                    // projectiles are spawned inside whoever fired them.
+                    // that isn't a hit.
+                    if (proj->owner == ent_idx &&
+                        x0 > el && x0 < er && y0 > et && y0 < eb)
                     {
-                        keep = entity->behavior->proj_touch(entity, proj);
+                        continue;
                     }
-                    else
+
+                    FIXED t0;
+                    if (!segment_hits_box(x0, y0, sweep->dx, sweep->dy,
+                                          el, et, er, eb, &t0))
                     {
-                        keep = false;
+                        continue;
                     }
-                    
-                    if (!keep)
-                        projectile_queue_free(proj);
+
+                    // ties go to whichever entity came first in col_ents
+                    if (sweep->hit_ent >= 0 && t0 >= sweep->hit_t) continue;
+                    sweep->hit_t = t0;
+                    sweep->hit_ent = (s16) ent_idx;
                 }
             }
         }
     }
+
+    // proj_touch callbacks can spawn projectiles, which shifts the active
+    // list, so gather the hits before running any of them.
+    proj_ent_hit_count = 0;
+    for (int k = 0; k < proj_count; ++k)
+    {
+        const int i = g_game.active_projs[k];
+        if (proj_sweeps[i].hit_ent >= 0)
+            proj_ent_hits[proj_ent_hit_count++] = (u8) i;
+    }
+
+    for (int k = 0; k < proj_ent_hit_count; ++k)
+    {
+        projectile_s *proj = g_game.projectiles + proj_ent_hits[k];
+
+        // proj_touch callbacks may have freed it
+        if (!IS_PROJ_ACTIVE(proj)) continue;
+        if (proj->flags & PROJ_FLAG_QFREE) continue;
+        if (proj->did_touch_this_frame) continue;
+
+        entity_coldata_s *col_ent =
+            col_ent_map + proj_sweeps[proj_ent_hits[k]].hit_ent;
+        entity_s *entity = col_ent->ent;
+
+        // ...or removed the entity it hit
+        if (!entity) continue;
+
+        proj->did_touch_this_frame = true;
+
+        // getting hit wakes a body up, since the callback will probably knock
+        // it around
+        if (entity->flags & ENTITY_FLAG_SLEEPING)
+            wake_island(col_ent->island);
+
+        bool keep;
+        if (entity->behavior && entity->behavior->proj_touch)
+            keep = entity->behavior->proj_touch(entity, proj);
+        else
+            keep = false;
+
+        if (!keep)
+            projectile_queue_free(proj);
+    }
+
+    for (int k = 0; k < proj_wall_hit_count; ++k)
+    {
+        // it was Destroyed.
+        projectile_s *proj = g_game.projectiles + proj_wall_hits[k];
+        if (IS_PROJ_ACTIVE(proj) && !(proj->flags & PROJ_FLAG_QFREE))
+            projectile_queue_free(proj);
+    }
 }
 
 #pragma endregion projectile physics
@@ -1148,27 +1908,26 @@ void game_physics_init(void)
 {
     col_ent_count = 0;
     col_contact_count = 0;
-    x_overlap_count = 0;
     x_edge_count = 0;
-    y_edge_count = 0;
     
     for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
         col_ent_map[i] = (entity_coldata_s){0};
+    for (int i = 0; i < ENTITY_MASK_WORDS; ++i)
+    {
+        col_ent_mask[i] = 0;
+        actor_ent_mask[i] = 0;
+    }
 
-    for (int i = 0; i < PARTGRID_NODE_POOL_SIZE - 1; ++i)
-        partgrid_node_pool[i] = (partgrid_node_s)
-        {
-            .next_free = partgrid_node_pool + i + 1
-        };
-
-    partgrid_node_pool[PARTGRID_NODE_POOL_SIZE - 1] = (partgrid_node_s){0};
-    partgrid_node_pool_ffree = partgrid_node_pool;
+    partgrid_resize(0, 0);
 
-    for (int i = 0; i < PARTGRID_COLS * PARTGRID_ROWS; ++i)
-        ((part_cell_t *)partgrid)[i] = NULL;
+    overlap_set_clear(&x_overlaps);
+    warm_contacts_clear();
+}
 
-    memset32(x_contact_pairs, 0, ENTITY_PAIR_SIZE / 4);
-    memset32(y_contact_pairs, 0, ENTITY_PAIR_SIZE / 4);
+void game_physics_on_room_load(void)
+{
+    partgrid_resize(g_game.room_width, g_game.room_height);
+    warm_contacts_clear();
 }
 
 void game_physics_on_entity_alloc(entity_s *ent) {}
@@ -1182,12 +1941,13 @@ void game_physics_on_entity_free(entity_s *ent)
     
     col_ent_removed(i);
     col->ent = NULL;
+    col_ent_mask[i >> 5] &= ~(1u << (i & 31));
 }
 
 void game_physics_update(void)
 {    
     #ifdef PHYS_PROFILE
-    profile = (struct phys_profile){0};
+    game_physics_profile = (game_physics_profile_s){0};
     #endif
 
     PROFILE_START();
@@ -1204,64 +1964,87 @@ void game_physics_update(void)
     //    entity
     //  - cache inverse mass and half-extents (although caching size-related data
     //    is probably pointless for performance...)
-    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+    //
+    // entities that stopped being actors since the last update get their
+    // contact flags cleared one last time too. otherwise they keep whatever
+    // they had when they stopped, like a dead player that's still grounded
+    // as it flies off.
+    for (int w = 0; w < ENTITY_MASK_WORDS; ++w)
     {
-        entity_s *entity = g_game.entities + i;
+        const u32 actors = g_game.ent_caps[ENTITY_CAP_ACTOR][w];
+        for (u32 bits = actors | actor_ent_mask[w]; bits; bits &= bits - 1)
+        {
+            const int i = (w << 5) + bit_ctz32(bits);
+            g_game.entities[i].actor.flags &= ~(ACTOR_FLAG_GROUNDED |
+                                                ACTOR_FLAG_WALL);
+        }
 
-        bool is_col_ent = (entity->flags & ENTITY_FLAG_ENABLED) &&
-                          (entity->flags & ENTITY_FLAG_COLLIDE);
+        actor_ent_mask[w] = actors;
+    }
 
-        if (is_col_ent)
+    // freed entities were already removed by game_physics_on_entity_free.
+    // what's left to sync up is the colliders that were just added, and the
+    // ones that stopped colliding, which are both in this union.
+    for (int w = 0; w < ENTITY_MASK_WORDS; ++w)
+    {
+        u32 bits = g_game.ent_caps[ENTITY_CAP_COLLIDE][w] | col_ent_mask[w];
+        for (; bits; bits &= bits - 1)
         {
-            if (!col_ent_map[i].ent)
+            const int i = (w << 5) + bit_ctz32(bits);
+            entity_s *entity = g_game.entities + i;
+            const u32 bit = 1u << (i & 31);
+
+            if (entity->flags & ENTITY_FLAG_COLLIDE)
             {
-                col_ent_map[i].ent = entity;
-                col_ent_added(i);
+                if (!col_ent_map[i].ent)
+                {
+                    col_ent_map[i].ent = entity;
+                    col_ent_mask[w] |= bit;
+                    col_ent_added(i);
+                }
             }
-        }
-        else
-        {
-            if (col_ent_map[i].ent)
+            else
             {
                 col_ent_removed(i);
                 col_ent_map[i].ent = NULL;
+                col_ent_mask[w] &= ~bit;
+                continue;
             }
-        }
 
-        if (!(entity->flags & ENTITY_FLAG_ENABLED))
-            continue;
-        
-        if (entity->flags & ENTITY_FLAG_ACTOR)
-            entity->actor.flags &= ~(ACTOR_FLAG_GROUNDED | ACTOR_FLAG_WALL);
-        
-        if (!(entity->flags & ENTITY_FLAG_COLLIDE)) continue;
-        
-        entity_coldata_s *col_ent = &col_ent_map[i];
-        col_ent->inv_mass = fxdiv(FIX_ONE * 2, int2fx((int)entity->mass));
-        col_ent->width = int2fx((int) entity->col.w);
-        col_ent->height = int2fx((int) entity->col.h);
-        col_ent->half_width = col_ent->width / 2;
-        col_ent->half_height = col_ent->height / 2;
-
-        int speed = max(abs(entity->vel.x), abs(entity->vel.y));
-        int subst = ceil_div(speed, FIX_ONE * 4);
-        if (subst > substeps)
-            substeps = subst;
-
-        col_ents[col_ent_count++] = col_ent;
-    }
+            entity_coldata_s *col_ent = &col_ent_map[i];
+            col_ent->inv_mass = fxdiv(FIX_ONE * 2, int2fx((int)entity->mass));
+            col_ent->width = int2fx((int) entity->col.w);
+            col_ent->height = int2fx((int) entity->col.h);
+            col_ent->half_width = col_ent->width / 2;
+            col_ent->half_height = col_ent->height / 2;
+            col_ent->no_sleep = false;
+            island_parent[i] = (u16) i;
 
-    // find fastest-moving projectile, use for determining how many substeps
-    // the simulation will need
-    for (int i = 0; i < MAX_PROJECTILE_COUNT; ++i)
-    {
-        projectile_s *proj = g_game.projectiles + i;
-        if (!IS_PROJ_ACTIVE(proj)) continue;
+            if (entity->flags & ENTITY_FLAG_SLEEPING)
+            {
+                // something other than physics moved it, or it stopped being a
+                // dynamic body.
+                if (!(entity->flags & ENTITY_FLAG_MOVING) ||
+                    entity->vel.x != 0 || entity->vel.y != 0 ||
+                    entity->pos.x != col_ent->sleep_x ||
+                    entity->pos.y != col_ent->sleep_y)
+                {
+                    wake_island(col_ent->island);
+                }
+            }
+            else
+            {
+                col_ent->sleep_x = entity->pos.x;
+                col_ent->sleep_y = entity->pos.y;
+            }
+
+            int speed = max(abs(entity->vel.x), abs(entity->vel.y));
+            int subst = ceil_div(speed, FIX_ONE * 4);
+            if (subst > substeps)
+                substeps = subst;
 
-        int speed = max(abs(proj->vx), abs(proj->vy));
-        int subst = ceil_div(speed, FIX_ONE * 4);
-        if (subst > substeps)
-            substeps = subst;
+            col_ents[col_ent_count++] = col_ent;
+        }
     }
 
     // cap substeps to 8. but entities usually don't move very fast, so
@@ -1286,15 +2069,12 @@ void game_physics_update(void)
 
     PROFILE_START();
 
-    {
-        projectile_s *proj = g_game.projectiles;
-        uint i = 0;
-        for (; i < MAX_PROJECTILE_COUNT; ++i, ++proj)
-            proj->did_touch_this_frame = false;
-    }
+    for (int k = 0; k < g_game.active_proj_count; ++k)
+        g_game.projectiles[g_game.active_projs[k]].did_touch_this_frame = false;
 
-    for (int iter = 0; iter < 2; ++iter)
-        game_physics_move_projs(FIX_ONE / 2);
+    // projectiles are swept along their whole path in one go, so they don't
+    // need substeps
+    game_physics_move_projs();
 
     PROFILE_END(projectiles_t);
 
@@ -1304,7 +2084,9 @@ void game_physics_update(void)
             break;
     }
 
-    #ifdef PHYS_PROFILE
+    update_sleep();
+
+    #if defined(PHYS_PROFILE) && !defined(PHYS_PROFILE_QUIET)
     PROFILE_LOG("e detection time", detection_ent_t);
     PROFILE_LOG("t detection time", detection_tile_t);
     PROFILE_LOG("resolution time", resolution_t);
@@ -1313,33 +2095,41 @@ void game_physics_update(void)
     #endif
 }
 
-void game_physics_on_proj_alloc(projectile_s *proj)
-{
-    intptr_t idx = proj - g_game.projectiles; // does this do division??
-    proj_data[idx] = (proj_part_data_s)
-    {
-        .part_cell = NULL
-    };
-}
-
-void game_physics_on_proj_free(projectile_s *proj)
-{
-    intptr_t idx = proj - g_game.projectiles; // does this do division??
-    proj_part_data_s *data = proj_data + idx;
-
-    if (data->part_cell)
-    {
-        partgrid_node_s *cell = partgrid_cell_remove(data->part_cell, proj);
-        *data = (proj_part_data_s){0};
-
-        if (!cell)
-        {
-            LOG_WRN("game_physics_on_proj_free: projectile is not in partgrid?");
-            return;
-        }
-
-        partgrid_node_free(cell);
-    }
-}
+// the partition grid is rebuilt every time projectiles move, so there is
+// nothing to do here
+void game_physics_on_proj_alloc(projectile_s *proj) {}
+void game_physics_on_proj_free(projectile_s *proj) {}
+
+#ifdef PLATFORM_PC
+const savestate_region_s game_physics_savestate_regions[] = {
+    SAVESTATE_REGION(col_ent_count),
+    SAVESTATE_REGION(col_ent_map),
+    SAVESTATE_REGION(col_ents),
+    SAVESTATE_REGION(col_ent_mask),
+    SAVESTATE_REGION(actor_ent_mask),
+    SAVESTATE_REGION(col_contact_count),
+    SAVESTATE_REGION(col_contacts),
+    SAVESTATE_REGION(x_overlaps),
+    SAVESTATE_REGION(warm_contact_count),
+    SAVESTATE_REGION(warm_contacts),
+    SAVESTATE_REGION(warm_contact_cur),
+    SAVESTATE_REGION(x_edge_count),
+    SAVESTATE_REGION(x_edges),
+    SAVESTATE_REGION(island_parent),
+    SAVESTATE_REGION(island_still),
+    SAVESTATE_REGION(partgrid_cols),
+    SAVESTATE_REGION(partgrid_rows),
+    SAVESTATE_REGION(partgrid_cel_shift),
+    SAVESTATE_REGION(partgrid_cell_start),
+    SAVESTATE_REGION(partgrid_projs),
+    SAVESTATE_REGION(proj_cells),
+    SAVESTATE_REGION(proj_sweeps),
+    SAVESTATE_REGION(proj_ent_hit_count),
+    SAVESTATE_REGION(proj_ent_hits),
+    SAVESTATE_REGION(proj_wall_hit_count),
+    SAVESTATE_REGION(proj_wall_hits),
+    SAVESTATE_END
+};
+#endif
 
 #pragma endregion public
\ No newline at end of file
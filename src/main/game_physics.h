@@ -5,6 +5,29 @@
 
 void game_physics_init(void);
 void game_physics_update(void);
+void game_physics_on_room_load(void);
+
+#ifdef PHYS_PROFILE
+// timings are in profile_stop() units
+typedef struct game_physics_profile
+{
+    u32 detection_ent_t;
+    u32 detection_tile_t;
+    u32 resolution_t;
+    u32 move_t;
+    u32 start_t;
+    u32 projectiles_t;
+
+    u32 contact_count; // summed over every iteration
+    u32 iteration_count;
+    u32 warm_contact_count; // contacts resolved by warm-starting
+    u32 sleeping_count; // bodies asleep at the end of the update
+}
+game_physics_profile_s;
+
+// profile of the last game_physics_update call
+extern game_physics_profile_s game_physics_profile;
+#endif
 
 void game_physics_on_entity_alloc(entity_s *ent);
 void game_physics_on_entity_free(entity_s *ent);
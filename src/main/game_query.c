@@ -0,0 +1,356 @@
+#include <stdlib.h>
+#include <tonc_math.h>
+#include <tonc_types.h>
+#include <log.h>
+
+#include "game.h"
+#include "game_query.h"
+#include "math_util.h"
+#include <platutil.h>
+
+#define TILE_FX (WORLD_TILE_SIZE * FIX_ONE)
+
+static inline bool tile_matches(int tx, int ty, uint tiles)
+{
+    return tiles & (1u << game_get_col_clamped(tx, ty));
+}
+
+static inline bool ray_hit(query_ray_hit_s *hit, FIXED x, FIXED y, int tx,
+                           int ty, int nx, int ny)
+{
+    if (hit)
+    {
+        *hit = (query_ray_hit_s)
+        {
+            .x = x,
+            .y = y,
+            .tx = (s16) tx,
+            .ty = (s16) ty,
+            .nx = (s8) nx,
+            .ny = (s8) ny
+        };
+    }
+
+    return true;
+}
+
+ARM_FUNC
+bool game_query_ray(FIXED x0, FIXED y0, FIXED x1, FIXED y1, uint tiles,
+                    query_ray_hit_s *hit)
+{
+    int tx = query_tile_coord(x0);
+    int ty = query_tile_coord(y0);
+
+    if (tile_matches(tx, ty, tiles))
+        return ray_hit(hit, x0, y0, tx, ty, 0, 0);
+
+    const FIXED dx = x1 - x0;
+    const FIXED dy = y1 - y0;
+    int n = abs(query_tile_coord(x1) - tx) + abs(query_tile_coord(y1) - ty);
+
+    const int step_x = dx < 0 ? -1 : 1;
+    const int step_y = dy < 0 ? -1 : 1;
+    const FIXED adx = abs(dx);
+    const FIXED ady = abs(dy);
+
+    // distance along each axis from the start to the next tile boundary
+    FIXED bx = (dx < 0) ? x0 - tx * TILE_FX : (tx + 1) * TILE_FX - x0;
+    FIXED by = (dy < 0) ? y0 - ty * TILE_FX : (ty + 1) * TILE_FX - y0;
+
+    for (; n > 0; --n)
+    {
+        // step along the axis whose boundary comes first. this compares
+        // bx / adx against by / ady, without dividing. the products of two
+        // FIXEDs don't fit in 32 bits once the ray is a couple hundred
+        // pixels long, so these are done in 64.
+        if ((s64) bx * ady < (s64) by * adx)
+        {
+            tx += step_x;
+            if (tile_matches(tx, ty, tiles))
+            {
+                return ray_hit(hit, x0 + bx * step_x,
+                               y0 + (FIXED)((s64) dy * bx / adx),
+                               tx, ty, -step_x, 0);
+            }
+
+            bx += TILE_FX;
+        }
+        else
+        {
+            ty += step_y;
+            if (tile_matches(tx, ty, tiles))
+            {
+                return ray_hit(hit, x0 + (FIXED)((s64) dx * by / ady),
+                               y0 + by * step_y, tx, ty, 0, -step_y);
+            }
+
+            by += TILE_FX;
+        }
+    }
+
+    return false;
+}
+
+bool game_query_rect(FIXED x, FIXED y, FIXED w, FIXED h, uint tiles)
+{
+    const int min_x = query_tile_coord(x);
+    const int min_y = query_tile_coord(y);
+    const int max_x = query_tile_coord(x + w);
+    const int max_y = query_tile_coord(y + h);
+
+    // solid and water tiles have bitmasks, so rows of them can be tested up
+    // to 32 tiles at once.
+    if (!(tiles & ~(QUERY_TILE_SOLID | QUERY_TILE_WATER)))
+    {
+        for (int ty = min_y; ty <= max_y; ++ty)
+        {
+            for (int x0 = min_x; x0 <= max_x; x0 += 32)
+            {
+                int n = max_x - x0 + 1;
+                if (n > 32) n = 32;
+
+                u32 bits = 0;
+                if (tiles & QUERY_TILE_SOLID)
+                    bits |= game_get_solid_bits(x0, ty, n);
+                if (tiles & QUERY_TILE_WATER)
+                    bits |= game_get_water_bits(x0, ty, n);
+
+                if (bits) return true;
+            }
+        }
+
+        return false;
+    }
+
+    for (int ty = min_y; ty <= max_y; ++ty)
+    {
+        for (int tx = min_x; tx <= max_x; ++tx)
+        {
+            if (tile_matches(tx, ty, tiles)) return true;
+        }
+    }
+
+    return false;
+}
+
+// colliding entities are put in a grid for game_query_entities. the physics
+// broadphase is only kept up to date while the physics update is running, and
+// behaviors spawn and move things in between, so it can't be used here.
+//
+// the grid is sized to the room the same way as the projectile grid, and is
+// rebuilt with a counting sort by the first query of each frame. it holds the
+// positions from that point on, so an entity that moves more than a cell
+// after that can be missed until the next frame. ones that start colliding
+// after it are checked one by one.
+#define ENTGRID_BASE_CEL_SHIFT 6
+#define ENTGRID_MAX_CELLS 128
+
+// cell ranges are stored in a u8
+_Static_assert(MAX_ENTITY_COUNT <= UINT8_MAX,
+               "MAX_ENTITY_COUNT too large for entgrid");
+
+static bool entgrid_stale = true;
+static int entgrid_cols = 1;
+static int entgrid_rows = 1;
+static int entgrid_cel_shift = ENTGRID_BASE_CEL_SHIFT;
+
+// entities are filed under the cell their top-left corner is in, so queries
+// look this much further up and to the left
+static int entgrid_max_w, entgrid_max_h;
+
+// the entities in cell c are entgrid_ents[entgrid_cell_start[c]] up to (but
+// not including) entgrid_ents[entgrid_cell_start[c + 1]].
+static u8 entgrid_cell_start[ENTGRID_MAX_CELLS + 1];
+static u8 entgrid_ents[MAX_ENTITY_COUNT];
+static u8 entgrid_ent_cells[MAX_ENTITY_COUNT];
+
+// slots that are in the grid, one bit each
+static u32 entgrid_mask[ENTITY_MASK_WORDS];
+
+void game_query_begin_frame(void)
+{
+    entgrid_stale = true;
+}
+
+static void entgrid_rebuild(void)
+{
+    // room size in world units
+    const int room_w = g_game.room_width * WORLD_TILE_SIZE;
+    const int room_h = g_game.room_height * WORLD_TILE_SIZE;
+
+    int cel_shift = ENTGRID_BASE_CEL_SHIFT;
+    int cols, rows;
+    for (;; ++cel_shift)
+    {
+        cols = CEIL_DIV(room_w, 1 << cel_shift);
+        rows = CEIL_DIV(room_h, 1 << cel_shift);
+        if (cols * rows <= ENTGRID_MAX_CELLS) break;
+    }
+
+    if (cols < 1) cols = 1;
+    if (rows < 1) rows = 1;
+
+    entgrid_cols = cols;
+    entgrid_rows = rows;
+    entgrid_cel_shift = cel_shift;
+    entgrid_max_w = 0;
+    entgrid_max_h = 0;
+
+    const int cell_count = cols * rows;
+    const int shift = cel_shift + FIX_SHIFT;
+
+    for (int i = 0; i < cell_count; ++i)
+        entgrid_cell_start[i] = 0;
+
+    int ent_count = 0;
+    u8 ents[MAX_ENTITY_COUNT];
+
+    for (int id = entity_cap_next(ENTITY_CAP_COLLIDE, -1); id >= 0;
+         id = entity_cap_next(ENTITY_CAP_COLLIDE, id))
+    {
+        const entity_s *ent = g_game.entities + id;
+
+        // clamp position to the grid
+        int cx = iclamp(ent->pos.x >> shift, 0, cols - 1);
+        int cy = iclamp(ent->pos.y >> shift, 0, rows - 1);
+
+        int cell = cy * cols + cx;
+        entgrid_ent_cells[id] = (u8) cell;
+        ++entgrid_cell_start[cell];
+        ents[ent_count++] = (u8) id;
+
+        if (ent->col.w > entgrid_max_w) entgrid_max_w = ent->col.w;
+        if (ent->col.h > entgrid_max_h) entgrid_max_h = ent->col.h;
+    }
+
+    // turn the cell counts into end offsets, then scatter the entities into
+    // their cells. going backwards keeps each cell sorted by slot.
+    int sum = 0;
+    for (int i = 0; i < cell_count; ++i)
+    {
+        sum += entgrid_cell_start[i];
+        entgrid_cell_start[i] = (u8) sum;
+    }
+    entgrid_cell_start[cell_count] = (u8) sum;
+
+    for (int k = ent_count - 1; k >= 0; --k)
+    {
+        const int id = ents[k];
+        entgrid_ents[--entgrid_cell_start[entgrid_ent_cells[id]]] = (u8) id;
+    }
+
+    for (int w = 0; w < ENTITY_MASK_WORDS; ++w)
+        entgrid_mask[w] = g_game.ent_caps[ENTITY_CAP_COLLIDE][w];
+
+    entgrid_stale = false;
+}
+
+static inline bool query_entity_matches(const entity_s *ent, FIXED x, FIXED y,
+                                        FIXED w, FIXED h, uint col_groups)
+{
+    if (!(ent->col.group & col_groups)) return false;
+    if (ent->flags & ENTITY_FLAG_QFREE) return false;
+
+    const FIXED ex = ent->pos.x;
+    const FIXED ey = ent->pos.y;
+    if (ex >= x + w || x >= ex + int2fx(ent->col.w)) return false;
+    if (ey >= y + h || y >= ey + int2fx(ent->col.h)) return false;
+
+    return true;
+}
+
+int game_query_entities(FIXED x, FIXED y, FIXED w, FIXED h, uint col_groups,
+                        entity_s **out, int max_count)
+{
+    if (entgrid_stale) entgrid_rebuild();
+
+    const u32 *colliding = g_game.ent_caps[ENTITY_CAP_COLLIDE];
+    const int shift = entgrid_cel_shift + FIX_SHIFT;
+
+    // one extra cell on every side, for entities that moved since the
+    // rebuild
+    const FIXED margin = int2fx(1 << entgrid_cel_shift);
+    const int min_cx = iclamp((x - int2fx(entgrid_max_w) - margin) >> shift,
+                              0, entgrid_cols - 1);
+    const int min_cy = iclamp((y - int2fx(entgrid_max_h) - margin) >> shift,
+                              0, entgrid_rows - 1);
+    const int max_cx = iclamp((x + w + margin) >> shift, 0, entgrid_cols - 1);
+    const int max_cy = iclamp((y + h + margin) >> shift, 0, entgrid_rows - 1);
+
+    int count = 0;
+
+    for (int cy = min_cy; cy <= max_cy; ++cy)
+    {
+        for (int cx = min_cx; cx <= max_cx; ++cx)
+        {
+            const int cell = cy * entgrid_cols + cx;
+            const int end = entgrid_cell_start[cell + 1];
+
+            for (int k = entgrid_cell_start[cell]; k < end; ++k)
+            {
+                const int id = entgrid_ents[k];
+                entity_s *ent = g_game.entities + id;
+
+                // it may have stopped colliding since the rebuild
+                if (!(colliding[id >> 5] & (1u << (id & 31)))) continue;
+                if (!query_entity_matches(ent, x, y, w, h, col_groups))
+                    continue;
+
+                if (count < max_count)
+                    out[count] = ent;
+                ++count;
+            }
+        }
+    }
+
+    // entities that started colliding since the rebuild aren't in the grid
+    for (int i = 0; i < ENTITY_MASK_WORDS; ++i)
+    {
+        for (u32 bits = colliding[i] & ~entgrid_mask[i]; bits;
+             bits &= bits - 1)
+        {
+            entity_s *ent = g_game.entities + (i << 5) + bit_ctz32(bits);
+            if (!query_entity_matches(ent, x, y, w, h, col_groups)) continue;
+
+            if (count < max_count)
+                out[count] = ent;
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+// twice the height after k steps, so it stays an integer
+static inline int fall_y2(FIXED y, FIXED vy, FIXED g, int k)
+{
+    return 2 * y + 2 * k * vy + g * k * (k + 1);
+}
+
+int game_query_fall_steps(FIXED y, FIXED vy, FIXED g, FIXED target_y)
+{
+    if (g <= 0)
+    {
+        LOG_ERR("game_query_fall_steps: g must be positive");
+        return 0;
+    }
+
+    // after k steps, the velocity is vy + k * g and the height is
+    //   y + k * vy + g * k * (k + 1) / 2
+    // which only goes down once the velocity is positive. that's step k0.
+    const int k0 = (vy < 0) ? -vy / g + 1 : 1;
+    const int target_y2 = target_y * 2;
+    if (fall_y2(y, vy, g, k0) >= target_y2) return k0;
+
+    // otherwise, solve the quadratic for where it reaches target_y. the
+    // square root is rounded, so nudge the result onto the exact step.
+    const int b = 2 * vy + g;
+    const int c = 2 * (y - target_y);
+    int k = (isqrt(b * b - 4 * g * c) - b) / (2 * g);
+    if (k < k0) k = k0;
+
+    while (fall_y2(y, vy, g, k) < target_y2) ++k;
+    while (k > k0 && fall_y2(y, vy, g, k - 1) >= target_y2) --k;
+
+    return k;
+}
@@ -0,0 +1,64 @@
+#ifndef GAME_QUERY_H
+#define GAME_QUERY_H
+
+#include "game.h"
+
+// queries against the room's collision map and the entities in it, for
+// behaviors that need to look around (line of sight, landing spots, etc.)
+// without poking at tiles one by one.
+
+// kinds of tiles to look for. one bit per collision map value.
+#define QUERY_TILE_AIR   (1 << 0)
+#define QUERY_TILE_SOLID (1 << 1)
+#define QUERY_TILE_WATER (1 << 2)
+#define QUERY_TILE_HEAT  (1 << 3)
+
+typedef struct query_ray_hit
+{
+    FIXED x, y; // where the ray entered the tile
+    s16 tx, ty; // the tile that was hit
+    s8 nx, ny; // side of the tile it entered through. 0 if it started inside
+}
+query_ray_hit_s;
+
+// the tile that contains the given world position
+static inline int query_tile_coord(FIXED v)
+{
+    int t = v / (WORLD_TILE_SIZE * FIX_ONE);
+    if (v < 0 && t * (WORLD_TILE_SIZE * FIX_ONE) != v) --t;
+    return t;
+}
+
+// walks every tile that the segment from (x0, y0) to (x1, y1) passes through,
+// in order, starting with the one it starts in. returns true at the first one
+// whose kind is in tiles. hit can be NULL.
+bool game_query_ray(FIXED x0, FIXED y0, FIXED x1, FIXED y1, uint tiles,
+                    query_ray_hit_s *hit);
+
+// returns true if any tile whose kind is in tiles touches the box. the edges
+// of the box count, so a box with no size tests a single point.
+bool game_query_rect(FIXED x, FIXED y, FIXED w, FIXED h, uint tiles);
+
+static inline bool game_query_point(FIXED x, FIXED y, uint tiles)
+{
+    return game_query_rect(x, y, 0, 0, tiles);
+}
+
+// finds colliding entities whose collision group is in col_groups and whose
+// box overlaps the given box. up to max_count of them are written to out,
+// and the number found is returned. this goes through a grid that is built
+// once per frame, by the first call. an entity that moved more than a grid
+// cell (64 world units or more, depending on the room size) since then can be
+// missed.
+int game_query_entities(FIXED x, FIXED y, FIXED w, FIXED h, uint col_groups,
+                        entity_s **out, int max_count);
+
+// marks the entity grid as out of date. called at the start of every frame.
+void game_query_begin_frame(void);
+
+// things like droplets move with vy += g, then y += vy, once per frame. this
+// returns after how many frames something starting at y with velocity vy
+// is falling and at or below target_y. g has to be positive.
+int game_query_fall_steps(FIXED y, FIXED vy, FIXED g, FIXED target_y);
+
+#endif
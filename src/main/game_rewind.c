@@ -0,0 +1,178 @@
+#include <tonc_types.h>
+#include <platutil.h>
+#include <log.h>
+
+#include "game_rewind.h"
+#include "savestate.h"
+
+// size of the ring buffer, in words. has to be a power of two. on gba this
+// is 64 KiB of ewram, which is several seconds of normal play. the pc has
+// memory to spare, so it keeps a lot more.
+#ifndef REWIND_BUFFER_WORDS
+#   ifdef PLATFORM_GBA
+#       define REWIND_BUFFER_WORDS (16 * 1024)
+#   else
+#       define REWIND_BUFFER_WORDS (1024 * 1024)
+#   endif
+#endif
+
+#define RING_MASK (REWIND_BUFFER_WORDS - 1)
+
+_Static_assert((REWIND_BUFFER_WORDS & RING_MASK) == 0,
+               "REWIND_BUFFER_WORDS must be a power of two");
+
+// each record is its payload length, the payload, then the length again. the
+// length at the front is only used for dropping the oldest record, and the
+// one at the end for popping the newest.
+//
+// the payload is a series of runs. each run is a header word, with the word
+// offset into the image in the low 16 bits and the number of words in the
+// high 16 bits, followed by that many xor'd words.
+EWRAM_BSS static u32 ring[REWIND_BUFFER_WORDS];
+
+// positions in the ring. these count up forever and wrap around with
+// RING_MASK, so head - tail is always the number of words in use.
+static u32 ring_head;
+static u32 ring_tail;
+static uint record_count;
+
+// start of the record being written, and whether it ran out of room
+static u32 record_start;
+static bool record_overflow;
+
+static bool ring_locked;
+
+static void drop_oldest(void)
+{
+    ring_tail += ring[ring_tail & RING_MASK] + 2;
+    --record_count;
+}
+
+static inline void write_word(u32 v)
+{
+    if (ring_head - ring_tail == REWIND_BUFFER_WORDS)
+    {
+        // the record being written takes up the whole buffer already, so
+        // there's nothing left to drop
+        if (ring_tail == record_start)
+        {
+            record_overflow = true;
+            return;
+        }
+
+        drop_oldest();
+    }
+
+    ring[ring_head & RING_MASK] = v;
+    ++ring_head;
+}
+
+void game_rewind_clear(void)
+{
+    ring_head = 0;
+    ring_tail = 0;
+    record_count = 0;
+}
+
+void game_rewind_set_locked(bool locked)
+{
+    ring_locked = locked;
+}
+
+void game_rewind_begin(void)
+{
+    if (ring_locked) return;
+
+    record_start = ring_head;
+    record_overflow = false;
+
+    // the length goes here once the record is done
+    write_word(0);
+}
+
+ARM_FUNC
+void game_rewind_put(u32 *image, uint ofs, const u32 *live, uint len)
+{
+    if (ring_locked) return;
+
+    u32 *img = image + ofs;
+    uint i = 0;
+
+    while (i < len)
+    {
+        if (img[i] == live[i])
+        {
+            ++i;
+            continue;
+        }
+
+        // a run costs a header word, so runs separated by a single unchanged
+        // word are stored as one
+        uint end = i + 1;
+        while (end < len && (img[end] != live[end] ||
+                             (end + 1 < len && img[end + 1] != live[end + 1])))
+        {
+            ++end;
+        }
+
+        write_word((ofs + i) | ((end - i) << 16));
+        for (; i < end; ++i)
+        {
+            write_word(img[i] ^ live[i]);
+            img[i] = live[i];
+        }
+    }
+}
+
+void game_rewind_end(void)
+{
+    if (ring_locked) return;
+
+    const u32 len = ring_head - record_start - 1;
+    write_word(len);
+
+    if (record_overflow)
+    {
+        // the image is still up to date, but this frame can't be undone, and
+        // so neither can anything before it
+        LOG_DBG("rewind record too large for buffer");
+        game_rewind_clear();
+        return;
+    }
+
+    ring[record_start & RING_MASK] = len;
+    ++record_count;
+}
+
+ARM_FUNC
+bool game_rewind_pop(u32 *image)
+{
+    if (record_count == 0) return false;
+
+    const u32 end = ring_head - 1;
+    const u32 start = end - ring[end & RING_MASK];
+
+    for (u32 p = start; p != end;)
+    {
+        const u32 header = ring[p++ & RING_MASK];
+        u32 *img = image + (header & 0xFFFF);
+
+        for (uint n = header >> 16; n > 0; --n)
+            *img++ ^= ring[p++ & RING_MASK];
+    }
+
+    ring_head = start - 1;
+    --record_count;
+    return true;
+}
+
+// the ring itself is left out. nothing is written to it while locked, and
+// popping only moves ring_head back.
+#ifdef PLATFORM_PC
+const savestate_region_s game_rewind_savestate_regions[] = {
+    SAVESTATE_REGION(ring_head),
+    SAVESTATE_REGION(ring_tail),
+    SAVESTATE_REGION(record_count),
+    SAVESTATE_END
+};
+#endif
@@ -0,0 +1,43 @@
+#ifndef GAME_REWIND_H
+#define GAME_REWIND_H
+
+#include <tonc_types.h>
+
+// history of the game state for stepping backwards, one record per frame.
+//
+// the state is an image of words owned by the caller, which always holds the
+// latest captured frame. capturing compares the live state against the image
+// and stores the xor of each run of changed words, then updates the image.
+// most of the state doesn't change from frame to frame, so most frames only
+// take a few words. popping a record xors it back into the image, which turns
+// the image back into the frame before it.
+//
+// records go into a fixed-size ring buffer. when it runs out of room, the
+// oldest records are dropped to make space.
+
+// images have to be smaller than this many words, since offsets into them are
+// stored in 16 bits
+#define REWIND_MAX_IMAGE_WORDS 0x10000
+
+// drops every record
+void game_rewind_clear(void);
+
+// starts a new record. every game_rewind_put call until game_rewind_end goes
+// into it.
+void game_rewind_begin(void);
+
+// diffs len words of live state against the image, starting ofs words into
+// it, and makes that part of the image match the live state
+void game_rewind_put(u32 *image, uint ofs, const u32 *live, uint len);
+
+void game_rewind_end(void);
+
+// undoes the newest record in the image. returns false if there are no
+// records left.
+bool game_rewind_pop(u32 *image);
+
+// while locked, nothing new gets recorded and the image isn't updated, but
+// popping still works. for running frames that are going to be undone.
+void game_rewind_set_locked(bool locked);
+
+#endif
@@ -3,9 +3,10 @@
 #include <tonc.h>
 #include <platutil.h>
 #include <data/graphics/font_gfx.h>
-#include <data/color_qlut_bin.h>
+#include <data/color_fade_bin.h>
 #include "gfx.h"
 #include "math_util.h"
+#include "savestate.h"
 
 
 
@@ -175,26 +176,11 @@ static void apply_palette_multiply(FIXED factor)
     if      (factor < 0)       factor = 0;
     else if (factor > FIX_ONE) factor = FIX_ONE;
 
-    // const FIXED scale_factor = TO_FIXED(256.0 / 31.0) + 1;
-
+    // tools/color.py has already worked out which palette color each color
+    // turns into at every level, so this is just a lookup
+    const u8 *fade = color_fade_bin + factor * 16;
     for (int i = 1; i < 16; ++i)
-    {
-        uint color = gfx_palette_normal[i];
-        
-        FIXED rf = int2fx(color & 0x1F);
-        FIXED gf = int2fx((color >> 5) & 0x1F);
-        FIXED bf = int2fx((color >> 10) & 0x1F);
-        rf = fxmul(rf, factor);
-        gf = fxmul(gf, factor);
-        bf = fxmul(bf, factor);
-        uint r = fx2int(rf);
-        uint g = fx2int(gf);
-        uint b = fx2int(bf);
-
-        uint lut_idx = r * (32 * 32) + g * 32 + b;
-        uint color_idx = (color_qlut_bin[lut_idx>>1] >> ((lut_idx&1) * 4)) & 0xF;
-        gfx_mul_palette[i] = gfx_palette[color_idx];
-    }
+        gfx_mul_palette[i] = gfx_palette[fade[i]];
 
     for (int i = 1; i < 16; ++i)
     {
@@ -280,10 +266,42 @@ typedef struct bg_scroll_data
     int old_offset_x;
     int old_offset_y;
     bool screen_dirty;
+    bool use_spare; // drawn into the spare screenblock instead of the usual one
 } bg_scroll_data_s;
 
 static EWRAM_BSS bg_scroll_data_s bg_scroll_data[4];
 
+static const uint gfx_bg_indices[4] = {
+    GFX_BG0_INDEX, GFX_BG1_INDEX, GFX_BG2_INDEX, GFX_BG3_INDEX
+};
+
+// 0 if the bg doesn't have one
+static const uint gfx_bg_spare_indices[4] = {
+    0, GFX_BG1_SPARE_INDEX, 0, 0
+};
+
+// a screen drawn ahead of time by gfx_prefetch_map, into whichever screenblock
+// the bg isn't using
+static struct
+{
+    const void *map_data; // NULL if there isn't one
+    uint bg_idx;
+    int tx;
+    int ty;
+} map_prefetch;
+
+static inline uint bg_screenblock(uint bg_idx)
+{
+    return bg_scroll_data[bg_idx].use_spare
+           ? gfx_bg_spare_indices[bg_idx] : gfx_bg_indices[bg_idx];
+}
+
+static inline uint bg_other_screenblock(uint bg_idx)
+{
+    return bg_scroll_data[bg_idx].use_spare
+           ? gfx_bg_indices[bg_idx] : gfx_bg_spare_indices[bg_idx];
+}
+
 static inline int calc_srcpos(int pos, int size, gfx_map_border_e border_mode)
 {
     switch (border_mode)
@@ -302,144 +320,72 @@ static inline int calc_srcpos(int pos, int size, gfx_map_border_e border_mode)
     return pos;
 }
 
-static void update_map_scroll_t(uint bg_idx, uint size_shift, uint dst_shift,
-                                gfx_map_write_f writer)
+// map coordinates of count consecutive tiles starting at start, with the
+// border mode applied. only the first one goes through calc_srcpos.
+static inline void calc_src_span(u16 *out, int start, uint count, int size,
+                                 gfx_map_border_e border_mode)
 {
-    static const uint gfx_bg_indices[4] = {
-        GFX_BG0_INDEX, GFX_BG1_INDEX, GFX_BG2_INDEX, GFX_BG3_INDEX
-    };
+    int pos = calc_srcpos(start, size, border_mode);
 
-    gfx_bg_s *bg = gfx_ctl.bg + bg_idx;
-    bg_scroll_data_s *scroll_data = bg_scroll_data + bg_idx;
-
-    const u16 *map_data = bg->map.data;
-    SCR_ENTRY *se16 = se_mem[gfx_bg_indices[bg_idx]];
-
-    int prev_cam_tx = scroll_data->old_offset_x >> size_shift;
-    int cam_tx = bg->offset_x >> size_shift;
-
-    int prev_cam_ty = scroll_data->old_offset_y >> size_shift;
-    int cam_ty = bg->offset_y >> size_shift;
-
-    uint size_mod_mask = (256 >> size_shift) - 1;
-
-    const uint width_div = SCREEN_WIDTH >> size_shift;
-    const uint height_div = SCREEN_HEIGHT >> size_shift;
-
-    const uint map_width = bg->map_width;
-    const uint map_height = bg->map_height;
-    const gfx_map_border_e border_x = bg->map.border_x;
-    const gfx_map_border_e border_y = bg->map.border_y;
-
-#define CALC_SRCPOS_X(x) calc_srcpos(x, map_width, border_x)
-#define CALC_SRCPOS_Y(y) calc_srcpos(y, map_height, border_y)
-
-    if (scroll_data->screen_dirty)
+    if (border_mode == GFX_MAP_BORDER_WRAP)
     {
-        scroll_data->screen_dirty = false;
-        int ey = cam_ty + height_div + 1;
-        int ex = cam_tx + width_div + 1;
-
-        int srcx, srcy;
-        for (int y = cam_ty; y < ey; ++y)
+        for (uint i = 0; i < count; ++i)
         {
-            srcy = CALC_SRCPOS_Y(y);
-            for (int x = cam_tx; x < ex; ++x)
-            {
-                srcx = CALC_SRCPOS_X(x);
-
-                uint ii = srcy * map_width + srcx;
-                uint oi = ((y & size_mod_mask) << 5) + (x & size_mod_mask);
-                uint entry = (uint) map_data[ii];
-                writer(entry, se16 + (oi << dst_shift));
-            }
+            out[i] = (u16) pos;
+            if (++pos == size) pos = 0;
         }
     }
     else
     {
-        // x scrolling (also handles corners)
-        if (cam_tx != prev_cam_tx)
+        for (uint i = 0; i < count; ++i, ++start)
         {
-            int sx, ex;
-            if (cam_tx > prev_cam_tx)
-            {
-                sx = prev_cam_tx + width_div + 1;
-                ex = cam_tx + width_div;
-            }
-            else
-            {
-                sx = cam_tx;
-                ex = prev_cam_tx;
-            }
-
-            int sy = cam_ty;
-            int ey = cam_ty + height_div;
-
-            int srcx, srcy;
-            for (int x = sx; x <= ex; ++x)
-            {
-                srcx = CALC_SRCPOS_X(x);
-                for (int y = sy; y <= ey; ++y)
-                {
-                    srcy = CALC_SRCPOS_Y(y);
-
-                    uint ii = srcy * bg->map_width + srcx;
-                    uint oi = ((y & size_mod_mask) << 5) + (x & size_mod_mask);
-                    uint entry = (uint) map_data[ii];
-                    writer(entry, se16 + (oi << dst_shift));
-                }
-            }
+            out[i] = (u16) pos;
+            if (start >= 0 && pos < size - 1) ++pos;
         }
+    }
+}
 
-        // y scrolling
-        if (cam_ty != prev_cam_ty)
-        {
-            int sy, ey;
-            if (cam_ty > prev_cam_ty)
-            {
-                sy = prev_cam_ty + height_div + 1;
-                ey = cam_ty + height_div;
-            }
-            else
-            {
-                sy = cam_ty == 0 ? 0 : cam_ty - 1;
-                ey = prev_cam_ty == 0 ? 0 : prev_cam_ty - 1;
-            }
+static inline uint map_size_shift(const gfx_map_s *map)
+{
+    return map->gfx_format == GFX_MAP_FORMAT_GBA ? 3 : 4;
+}
 
-            int sx = cam_tx;
-            int ex = cam_tx + width_div;
+// a rectangle of map tiles to be written to a screenblock. x0 and y0 are where
+// it starts on the (endless) screen, and src_rows/src_x are where each of its
+// rows and columns come from in the map.
+#define MAP_BLIT_MAX_SPAN 32
 
-            int srcx, srcy;
-            for (int y = sy; y <= ey; ++y)
-            {
-                srcy = CALC_SRCPOS_Y(y);
-                for (int x = sx; x <= ex; ++x)
-                {
-                    srcx = CALC_SRCPOS_X(x);
+typedef struct map_blit
+{
+    int x0, y0;
+    uint cols, rows;
+    const u16 *src_rows[MAP_BLIT_MAX_SPAN];
+    u16 src_x[MAP_BLIT_MAX_SPAN];
+} map_blit_s;
+
+// one screen entry per map entry
+ARM_FUNC
+static void blit_map_gba(const map_blit_s *blit, SCR_ENTRY *se16)
+{
+    for (uint r = 0; r < blit->rows; ++r)
+    {
+        const u16 *src = blit->src_rows[r];
+        u16 *dst = se16 + (((blit->y0 + r) & 31) << 5);
 
-                    uint ii = srcy * bg->map_width + srcx;
-                    uint oi = ((y & size_mod_mask) << 5) + (x & size_mod_mask);
-                    uint entry = (uint) map_data[ii];
-                    writer(entry, se16 + (oi << dst_shift));
-                }
-            }
-        }
+        uint x = blit->x0;
+        for (uint c = 0; c < blit->cols; ++c, ++x)
+            dst[x & 31] = src[blit->src_x[c]];
     }
-
-#undef CALC_SRCPOS_X
-#undef CALC_SRCPOS_Y
 }
 
-IWRAM_CODE
-static void write_se_mapc(const uint map_entry, u16 *p_dest)
+// each map entry is a 16x16 metatile, so 2x2 screen entries. the top and
+// bottom halves are each written as one word.
+static inline void mapc_se_pair(uint map_entry, u32 *p_upper, u32 *p_lower)
 {
-    // dest should always be 32-bit aligned, since dst stride is 2
-    u32 *dest = (u32 *)p_dest;
-
     if (map_entry == 0)
     {
-        *dest        = 0;
-        *(dest + 16) = 0;
+        *p_upper = 0;
+        *p_lower = 0;
         return;
     }
 
@@ -470,46 +416,205 @@ static void write_se_mapc(const uint map_entry, u16 *p_dest)
         lower |= SE_VFLIP | (SE_VFLIP << 16);
     }
 
-    *dest = upper;
-    *(dest + 16) = lower;
+    *p_upper = upper;
+    *p_lower = lower;
+}
+
+// mapc_se_pair for every possible map entry (gfx id and the two flip bits),
+// so scrolling only has to look them up. the tileset is always in the same
+// place, so it's only built once. not EWRAM_BSS, since it's read for every
+// metatile drawn and iwram is a lot faster to read from.
+#define MAPC_SE_TABLE_SIZE 0x400
+
+static u32 mapc_se_table[MAPC_SE_TABLE_SIZE][2];
+static bool mapc_se_table_built = false;
+
+static void build_mapc_se_table(void)
+{
+    if (mapc_se_table_built) return;
+
+    for (uint i = 0; i < MAPC_SE_TABLE_SIZE; ++i)
+        mapc_se_pair(i, &mapc_se_table[i][0], &mapc_se_table[i][1]);
+
+    mapc_se_table_built = true;
+}
+
+ARM_FUNC
+static void blit_map_mapc16(const map_blit_s *blit, SCR_ENTRY *se16)
+{
+    for (uint r = 0; r < blit->rows; ++r)
+    {
+        const u16 *src = blit->src_rows[r];
+        u32 *dst = (u32 *)se16 + (((blit->y0 + r) & 15) << 5);
+
+        uint x = blit->x0;
+        for (uint c = 0; c < blit->cols; ++c, ++x)
+        {
+            const u32 *pair =
+                mapc_se_table[src[blit->src_x[c]] & (MAPC_SE_TABLE_SIZE - 1)];
+            dst[x & 15]        = pair[0];
+            dst[(x & 15) + 16] = pair[1];
+        }
+    }
+}
+
+// same layout as mapc16, but the user decides what goes in the screen entries
+static void blit_map_custom16(const map_blit_s *blit, SCR_ENTRY *se16,
+                              gfx_map_write_f writer)
+{
+    for (uint r = 0; r < blit->rows; ++r)
+    {
+        const u16 *src = blit->src_rows[r];
+        u16 *dst = se16 + (((blit->y0 + r) & 15) << 6);
+
+        uint x = blit->x0;
+        for (uint c = 0; c < blit->cols; ++c, ++x)
+            writer(src[blit->src_x[c]], dst + ((x & 15) << 1));
+    }
+}
+
+// writes the map tiles in the cols x rows rectangle starting at (x0, y0) to
+// se16. always goes row by row, so writes to vram are mostly sequential.
+static void blit_map_rect(const gfx_map_s *map, SCR_ENTRY *se16,
+                          int x0, int y0, int cols, int rows)
+{
+    const u16 *map_data = map->data;
+    map_blit_s blit;
+
+    // anything bigger than a screenblock wraps around onto itself, but it's
+    // still drawn in full so the last tile written to each entry is the
+    // same as it's always been
+    for (int ry = 0; ry < rows; ry += MAP_BLIT_MAX_SPAN)
+    {
+        blit.y0 = y0 + ry;
+        blit.rows = MIN(rows - ry, MAP_BLIT_MAX_SPAN);
+
+        u16 src_y[MAP_BLIT_MAX_SPAN];
+        calc_src_span(src_y, blit.y0, blit.rows, map->height, map->border_y);
+        for (uint r = 0; r < blit.rows; ++r)
+            blit.src_rows[r] = map_data + src_y[r] * map->width;
+
+        for (int rx = 0; rx < cols; rx += MAP_BLIT_MAX_SPAN)
+        {
+            blit.x0 = x0 + rx;
+            blit.cols = MIN(cols - rx, MAP_BLIT_MAX_SPAN);
+            calc_src_span(blit.src_x, blit.x0, blit.cols, map->width,
+                          map->border_x);
+
+            switch (map->gfx_format)
+            {
+            case GFX_MAP_FORMAT_GBA:
+                blit_map_gba(&blit, se16);
+                break;
+
+            case GFX_MAP_FORMAT_MAPC16:
+                blit_map_mapc16(&blit, se16);
+                break;
+
+            case GFX_MAP_FORMAT_CUSTOM16:
+                blit_map_custom16(&blit, se16, map->custom_write);
+                break;
+
+            default:
+                LOG_ERR("invalid map gfx format %u", map->gfx_format);
+                ASM_BREAK();
+                return;
+            }
+        }
+    }
 }
 
-IWRAM_CODE
-static void write_se_gba(const uint map_entry, u16 *dest)
+// draws the whole screen with its top-left corner at map tile (cam_tx, cam_ty)
+static void draw_map_screen(const gfx_map_s *map, SCR_ENTRY *se16,
+                            int cam_tx, int cam_ty)
 {
-    *dest = (u16) map_entry;
+    const uint size_shift = map_size_shift(map);
+    blit_map_rect(map, se16, cam_tx, cam_ty,
+                  (SCREEN_WIDTH >> size_shift) + 1,
+                  (SCREEN_HEIGHT >> size_shift) + 1);
 }
 
 static void update_map_scroll(uint bg_idx)
 {
     gfx_bg_s *bg = gfx_ctl.bg + bg_idx;
     bg_scroll_data_s *scroll_data = bg_scroll_data + bg_idx;
+    const gfx_map_s *map = &bg->map;
+
+    if (!map->data)
+        goto done;
 
-    if (bg->map.data)
+    const uint size_shift = map_size_shift(map);
+    SCR_ENTRY *se16 = se_mem[bg_screenblock(bg_idx)];
+
+    int prev_cam_tx = scroll_data->old_offset_x >> size_shift;
+    int cam_tx = bg->offset_x >> size_shift;
+
+    int prev_cam_ty = scroll_data->old_offset_y >> size_shift;
+    int cam_ty = bg->offset_y >> size_shift;
+
+    const int width_div = SCREEN_WIDTH >> size_shift;
+    const int height_div = SCREEN_HEIGHT >> size_shift;
+
+    if (scroll_data->screen_dirty)
     {
-        switch (bg->map.gfx_format)
+        scroll_data->screen_dirty = false;
+
+        // if this exact screen was already drawn into the other screenblock,
+        // just switch over to it
+        bool prefetched = false;
+        if (map_prefetch.map_data && map_prefetch.bg_idx == bg_idx)
         {
-        case GFX_MAP_FORMAT_GBA:
-            update_map_scroll_t(bg_idx, 3, 0, write_se_gba);
-            break;
+            prefetched = map_prefetch.map_data == map->data &&
+                         map_prefetch.tx == cam_tx &&
+                         map_prefetch.ty == cam_ty;
+            map_prefetch.map_data = NULL;
+        }
 
-        case GFX_MAP_FORMAT_MAPC16:
-            update_map_scroll_t(bg_idx, 4, 1, write_se_mapc);
-            break;
+        if (prefetched)
+            scroll_data->use_spare = !scroll_data->use_spare;
+        else
+            draw_map_screen(map, se16, cam_tx, cam_ty);
+
+        goto done;
+    }
 
-        case GFX_MAP_FORMAT_CUSTOM16:
+    // x scrolling (also handles corners)
+    if (cam_tx != prev_cam_tx)
+    {
+        int sx, ex;
+        if (cam_tx > prev_cam_tx)
         {
-            update_map_scroll_t(bg_idx, 4, 1, bg->map.custom_write);
-            break;
+            sx = prev_cam_tx + width_div + 1;
+            ex = cam_tx + width_div;
         }
-        
-        default:
-            LOG_ERR("invalid map gfx format %u", bg->map.gfx_format);
-            ASM_BREAK();
-            break;
+        else
+        {
+            sx = cam_tx;
+            ex = prev_cam_tx;
         }
+
+        blit_map_rect(map, se16, sx, cam_ty, ex - sx + 1, height_div + 1);
     }
 
+    // y scrolling
+    if (cam_ty != prev_cam_ty)
+    {
+        int sy, ey;
+        if (cam_ty > prev_cam_ty)
+        {
+            sy = prev_cam_ty + height_div + 1;
+            ey = cam_ty + height_div;
+        }
+        else
+        {
+            sy = cam_ty == 0 ? 0 : cam_ty - 1;
+            ey = prev_cam_ty == 0 ? 0 : prev_cam_ty - 1;
+        }
+
+        blit_map_rect(map, se16, cam_tx, sy, width_div + 1, ey - sy + 1);
+    }
+
+done:
     scroll_data->old_offset_x = bg->offset_x;
     scroll_data->old_offset_y = bg->offset_y;
 }
@@ -528,6 +633,44 @@ void gfx_load_map(uint bg_idx, const gfx_map_s *map)
     bg->map_width = map->width;
     bg->map_height = map->height;
     sdata->screen_dirty = true;
+
+    if (map->gfx_format == GFX_MAP_FORMAT_MAPC16)
+        build_mapc_se_table();
+}
+
+void gfx_unload_map(uint bg_idx)
+{
+    gfx_ctl.bg[bg_idx].map = (gfx_map_s){0};
+    gfx_ctl.bg[bg_idx].map_width = 0;
+    gfx_ctl.bg[bg_idx].map_height = 0;
+
+    // other scenes write to the usual screenblock directly
+    bg_scroll_data[bg_idx].use_spare = false;
+    if (map_prefetch.bg_idx == bg_idx)
+        map_prefetch.map_data = NULL;
+}
+
+void gfx_prefetch_map(uint bg_idx, const gfx_map_s *map,
+                      int offset_x, int offset_y)
+{
+    if (!gfx_bg_spare_indices[bg_idx])
+    {
+        LOG_ERR("bg %u has no spare screenblock", bg_idx);
+        return;
+    }
+
+    if (map->gfx_format == GFX_MAP_FORMAT_MAPC16)
+        build_mapc_se_table();
+
+    const uint size_shift = map_size_shift(map);
+
+    map_prefetch.map_data = map->data;
+    map_prefetch.bg_idx = bg_idx;
+    map_prefetch.tx = offset_x >> size_shift;
+    map_prefetch.ty = offset_y >> size_shift;
+
+    draw_map_screen(map, se_mem[bg_other_screenblock(bg_idx)],
+                    map_prefetch.tx, map_prefetch.ty);
 }
 
 #pragma endregion
@@ -546,7 +689,70 @@ void gfx_load_map(uint bg_idx, const gfx_map_s *map)
 #pragma region text engine
 
 EWRAM_BSS TILE gfx_text_bmp_buf[GFX_TEXT_BMP_SIZE];
-EWRAM_BSS bool gfx_text_bmp_dirty_rows[GFX_TEXT_BMP_ROWS + 2];
+
+// one bit per tile column, for each row of tiles
+EWRAM_BSS u32 gfx_text_bmp_dirty_cols[GFX_TEXT_BMP_ROWS + 2];
+
+// marks columns c0 to c1 of rows r0 to r1 (all inclusive) to be uploaded
+static inline void mark_text_tiles_dirty(uint c0, uint c1, uint r0, uint r1)
+{
+    if (c1 >= GFX_TEXT_BMP_COLS) c1 = GFX_TEXT_BMP_COLS - 1;
+    if (r1 > GFX_TEXT_BMP_ROWS + 1) r1 = GFX_TEXT_BMP_ROWS + 1;
+    if (c0 > c1) return;
+
+    const u32 mask = ((2u << c1) - 1) & ~((1u << c0) - 1);
+    for (uint r = r0; r <= r1; ++r)
+        gfx_text_bmp_dirty_cols[r] |= mask;
+}
+
+// copies the dirty tiles to vram. tiles next to each other in the bitmap are
+// next to each other in vram too, so each run of them is one copy, even where
+// it carries on into the next row. returns how many bytes were copied.
+static uint upload_text_bmp(void)
+{
+    uint total = 0;
+    uint run_start = 0;
+    uint run_end = 0; // run_start if there isn't one yet
+
+    for (uint r = 0; r < GFX_TEXT_BMP_ROWS; ++r)
+    {
+        u32 mask = gfx_text_bmp_dirty_cols[r] & ((1u << GFX_TEXT_BMP_COLS) - 1);
+
+        while (mask)
+        {
+            const uint c = bit_ctz32(mask);
+            const uint n = bit_ctz32(~(mask >> c));
+            mask &= ~(((1u << n) - 1) << c);
+
+            const uint i = r * GFX_TEXT_BMP_COLS + c;
+            if (i != run_end)
+            {
+                if (run_end != run_start)
+                {
+                    const uint sz = (run_end - run_start) * sizeof(TILE);
+                    dma3_cpy(GFX_TEXT_BMP_VRAM + run_start,
+                             gfx_text_bmp_buf + run_start, sz);
+                    total += sz;
+                }
+
+                run_start = i;
+            }
+
+            run_end = i + n;
+        }
+    }
+
+    if (run_end != run_start)
+    {
+        const uint sz = (run_end - run_start) * sizeof(TILE);
+        dma3_cpy(GFX_TEXT_BMP_VRAM + run_start, gfx_text_bmp_buf + run_start,
+                 sz);
+        total += sz;
+    }
+
+    memset(gfx_text_bmp_dirty_cols, 0, sizeof(gfx_text_bmp_dirty_cols));
+    return total;
+}
 
 ARM_FUNC void _gfx_text_blit_tile(uint x, uint y, const TILE4 *src_tile);
 
@@ -624,7 +830,7 @@ ARM_FUNC NO_INLINE
 void gfx_text_bmap_dst_clear(uint row, uint row_count)
 {
     gfx_queue_memset(&se_mem[GFX_BG0_INDEX][row * 32], 0,
-                     sizeof(SCR_ENTRY) * row_count * 32);
+                     sizeof(SCR_ENTRY) * row_count * 32, GFX_DMA_PRIO_HIGH);
 }
 
 ARM_FUNC NO_INLINE
@@ -645,7 +851,8 @@ void gfx_text_bmap_dst_assign(uint row, uint row_count, uint src_row,
         j += 2;
     }
 
-    gfx_queue_memcpy(&se_mem[GFX_BG0_INDEX][row * 32], alloc, sz);
+    gfx_queue_memcpy(&se_mem[GFX_BG0_INDEX][row * 32], alloc, sz,
+                     GFX_DMA_PRIO_HIGH);
 }
 
 ARM_FUNC NO_INLINE
@@ -925,16 +1132,13 @@ void gfx_text_bmap_print(uint x, uint y, const char *text,
         break;
     }
     
-    gfx_text_bmp_dirty_rows[y / 8] = true;
-    gfx_text_bmp_dirty_rows[y / 8 + 1] = true;
-    gfx_text_bmp_dirty_rows[(y + 15) / 8] = true;
-
     for (; *text != '\0'; ++text)
     {
         char ch = *text;
         if (ch == ' ') goto next_char;
 
         uint id = char_map[(u8) ch];
+        mark_text_tiles_dirty(x / 8, (x + 15) / 8, y / 8, (y + 15) / 8);
 
         const TILE *src_tile = text_data + id;
 
@@ -971,6 +1175,14 @@ void gfx_text_bmap_print(uint x, uint y, const char *text,
 //------------------------------------------------------------------------------
 #pragma region dma
 
+// what's left of vblank for the queue, after oam, palettes, the text bitmap and
+// map scrolling. the estimate is for copies from ewram to vram, which is the
+// slowest of the usual cases.
+#define DMA_VBLANK_CYCLES (68 * 1232)
+#define DMA_BUDGET_CYCLES (DMA_VBLANK_CYCLES / 2)
+#define DMA_CYCLES_PER_WORD 8
+#define DMA_SETUP_CYCLES 16
+
 typedef enum dma_req_t
 {
     GFX_DMA_MEMCPY32,
@@ -981,11 +1193,12 @@ dma_req_t_e;
 typedef struct gfx_dma_req
 {
     u8 type;
+    u8 prio;
     void *dst;
     union
     {
         const void *src;
-        uint value;
+        uint value; // the byte repeated across the whole word
     };
     size_t count;
 }
@@ -996,83 +1209,177 @@ static EWRAM_BSS gfx_dma_req_s dma_queue[DMA_QUEUE_MAX_SIZE];
 static u32 *dma_cpypool_write;
 static EWRAM_BSS u32 dma_cpypool[DMA_CPYPOOL_SIZE];
 
-#define CHECK_DMA_QUEUE()  \
-    if (dma_queue_size == DMA_QUEUE_MAX_SIZE)  \
-    {  \
-        LOG_ERR("DMA queue is full!");  \
-        return false;  \
+// if req carries on right where the last request in the queue ends, with the
+// same kind of transfer, that request is just made longer
+static bool coalesce_dma_req(const gfx_dma_req_s *req)
+{
+    if (dma_queue_size == 0) return false;
+
+    gfx_dma_req_s *last = dma_queue + dma_queue_size - 1;
+    if (last->type != req->type || last->prio != req->prio ||
+        (last->count & 3) || (u8 *)last->dst + last->count != req->dst)
+    {
+        return false;
+    }
+
+    if (req->type == GFX_DMA_MEMCPY32
+        ? (const u8 *)last->src + last->count != req->src
+        : last->value != req->value)
+    {
+        return false;
     }
 
-bool gfx_queue_memcpy(void *dst, const void *src, size_t size)
+    last->count += req->count;
+    return true;
+}
+
+static bool queue_dma_req(const gfx_dma_req_s *req)
 {
-    CHECK_DMA_QUEUE();
+    if (req->count & 1)
+    {
+        LOG_ERR("gfx dma size %u is odd", (uint) req->count);
+        return false;
+    }
+
+    if (coalesce_dma_req(req))
+        return true;
+
+    if (dma_queue_size == DMA_QUEUE_MAX_SIZE)
+    {
+        LOG_ERR("DMA queue is full!");
+        return false;
+    }
+
+    dma_queue[dma_queue_size++] = *req;
+    return true;
+}
 
-    dma_queue[dma_queue_size++] = (gfx_dma_req_s)
+bool gfx_queue_memcpy(void *dst, const void *src, size_t size,
+                      gfx_dma_prio_e prio)
+{
+    return queue_dma_req(&(gfx_dma_req_s)
     {
         .type = GFX_DMA_MEMCPY32,
+        .prio = prio,
         .dst = dst,
         .src = src,
         .count = size
-    };
-
-    return true;
+    });
 }
 
-bool gfx_queue_memset(void *dst, u8 value, size_t size)
+bool gfx_queue_memset(void *dst, u8 value, size_t size, gfx_dma_prio_e prio)
 {
-    CHECK_DMA_QUEUE();
-
-    dma_queue[dma_queue_size++] = (gfx_dma_req_s)
+    return queue_dma_req(&(gfx_dma_req_s)
     {
         .type = GFX_DMA_MEMSET32,
+        .prio = prio,
         .dst = dst,
-        .value = (uint) value,
+        .value = (uint) value * 0x01010101,
         .count = size
-    };
+    });
+}
 
-    return true;
+static inline uint dma_req_cycles(const gfx_dma_req_s *req)
+{
+    return DMA_SETUP_CYCLES + CEIL_DIV(req->count, 4) * DMA_CYCLES_PER_WORD;
 }
 
+static inline bool dma_reqs_overlap(const gfx_dma_req_s *a,
+                                    const gfx_dma_req_s *b)
+{
+    const u8 *a0 = a->dst, *b0 = b->dst;
+    return a0 < b0 + b->count && b0 < a0 + a->count;
+}
+
+static inline bool dma_req_uses_cpypool(const gfx_dma_req_s *req)
+{
+    if (req->type != GFX_DMA_MEMCPY32) return false;
+
+    const u32 *src = req->src;
+    return src >= dma_cpypool && src < dma_cpypool + DMA_CPYPOOL_SIZE;
+}
+
+static void run_dma_req(const gfx_dma_req_s *req)
+{
+    // sizes are always even, so any remainder is a single halfword
+    const size_t s = req->count & ~3;
+
+    if (req->type == GFX_DMA_MEMCPY32)
+    {
+        dma3_cpy(req->dst, req->src, req->count);
+        if (req->count & 2)
+        {
+            *(u16 *)((u8 *)req->dst + s) =
+                *(const u16 *)((const u8 *)req->src + s);
+        }
+    }
+    else if (req->type == GFX_DMA_MEMSET32)
+    {
+        dma3_fill(req->dst, req->value, req->count);
+        if (req->count & 2)
+            *(u16 *)((u8 *)req->dst + s) = (u16) req->value;
+    }
+    else
+    {
+        LOG_ERR("unknown gfx copy type %u", req->type);
+    }
+}
+
+// high-priority requests are always done. low-priority ones are done while
+// there's still time in the budget, and the rest are moved to the front of
+// the queue for next frame. once one is put off, all the low-priority ones
+// after it are too, so they still happen in order.
 static void flush_dma_queue(void)
 {
+    uint cycles = 0;
+    uint kept = 0;
+
     for (uint i = 0; i < dma_queue_size; ++i)
     {
-        gfx_dma_req_s *req = dma_queue + i;
+        const gfx_dma_req_s req = dma_queue[i];
+        const uint cost = dma_req_cycles(&req);
 
-        if (req->type == GFX_DMA_MEMCPY32)
+        if (req.prio == GFX_DMA_PRIO_LOW &&
+            (kept > 0 || (cycles > 0 && cycles + cost > DMA_BUDGET_CYCLES)))
         {
-            dma3_cpy(req->dst, req->src, req->count);
-            if (req->count & 3) // if not word-aligned, copy remainder
-            {
-                size_t s = req->count & ~3;
-                u8 *const dst = req->dst;
-                const u8 *const src = req->src;
-
-                dst[s] = src[s]; ++s;
-                dst[s] = src[s]; ++s;
-                dst[s] = src[s];
-            }
+            dma_queue[kept++] = req;
+            continue;
         }
-        else if (req->type == GFX_DMA_MEMSET32)
+
+        // anything put off that this would write over has to go first
+        for (uint j = 0; j < kept; ++j)
         {
-            dma3_fill(req->dst, req->value, req->count);
-            if (req->count & 3) // if not word-aligned, fill remainder
+            if (dma_reqs_overlap(dma_queue + j, &req))
             {
-                size_t s = req->count & ~3;
-                u8 *const dst = req->dst;
-                
-                dst[s++] = req->value;
-                dst[s++] = req->value;
-                dst[s]   = req->value;
+                for (uint k = 0; k < kept; ++k)
+                {
+                    run_dma_req(dma_queue + k);
+                    cycles += dma_req_cycles(dma_queue + k);
+                }
+
+                kept = 0;
+                break;
             }
         }
-        else
-        {
-            LOG_ERR("unknown gfx copy type %u", req->type);
-        }
+
+        run_dma_req(&req);
+        cycles += cost;
     }
-    dma_queue_size = 0;
-    dma_cpypool_write = dma_cpypool;
+
+#ifdef DEVDEBUG
+    if (cycles > DMA_BUDGET_CYCLES)
+        LOG_WRN("gfx dma over budget! %u cycles", cycles);
+#endif
+
+    dma_queue_size = kept;
+
+    // the pool can only start over once nothing left refers to it
+    bool pool_in_use = false;
+    for (uint i = 0; i < kept; ++i)
+        pool_in_use = pool_in_use || dma_req_uses_cpypool(dma_queue + i);
+
+    if (!pool_in_use)
+        dma_cpypool_write = dma_cpypool;
 }
 
 void* gfx_alloc_cpybuf(size_t size)
@@ -1131,6 +1438,8 @@ void gfx_init(void)
         bg_scroll_data[i] = (bg_scroll_data_s){0};
     };
 
+    map_prefetch.map_data = NULL;
+
     gfx_ctl.bg[0].enabled = true;
     gfx_ctl.bg[0].char_block = GFX_TEXT_BMP_BLOCK;
     gfx_ctl.bg[0].priority = 0;
@@ -1176,26 +1485,7 @@ void gfx_commit()
 
     flush_dma_queue();
 
-    uint text_dma_count = 0; // in bytes
-
-    for (uint r0 = 0; r0 < GFX_TEXT_BMP_ROWS;)
-    {
-        if (!gfx_text_bmp_dirty_rows[r0])
-        {
-            ++r0;
-            continue;
-        }
-        
-        uint r1 = r0 + 1;
-        while (r1 < GFX_TEXT_BMP_ROWS && gfx_text_bmp_dirty_rows[r1])
-            ++r1;
-
-        const uint ofs = r0 * GFX_TEXT_BMP_COLS;
-        const uint sz = ((r1 - r0) * GFX_TEXT_BMP_COLS) * sizeof(TILE);
-        dma3_cpy(GFX_TEXT_BMP_VRAM + ofs, gfx_text_bmp_buf + ofs, sz);
-        text_dma_count += sz;
-        r0 = r1;
-    }
+    uint text_dma_count = upload_text_bmp(); // in bytes
 
 #if false // #ifdef DEVDEBUG
     if (text_dma_count > 0)
@@ -1204,8 +1494,6 @@ void gfx_commit()
     (void)text_dma_count;
 #endif
 
-    memset(gfx_text_bmp_dirty_rows, 0, sizeof(gfx_text_bmp_dirty_rows));
-
     REG_BG0HOFS = gfx_ctl.bg[0].offset_x;
     REG_BG0VOFS = gfx_ctl.bg[0].offset_y;
     REG_BG1HOFS = gfx_ctl.bg[1].offset_x;
@@ -1218,10 +1506,10 @@ void gfx_commit()
     u32 reg_dispcnt = DCNT_OBJ_1D;
     u16 bg_cnt[4] = { 0, 0, 0, 0 };
     
-    bg_cnt[0] = BG_SBB(GFX_BG0_INDEX) | BG_REG_32x32;
-    bg_cnt[1] = BG_SBB(GFX_BG1_INDEX) | BG_REG_32x32;
-    bg_cnt[2] = BG_SBB(GFX_BG2_INDEX) | BG_REG_32x32;
-    bg_cnt[3] = BG_SBB(GFX_BG3_INDEX) | BG_REG_32x32;
+    bg_cnt[0] = BG_SBB(bg_screenblock(0)) | BG_REG_32x32;
+    bg_cnt[1] = BG_SBB(bg_screenblock(1)) | BG_REG_32x32;
+    bg_cnt[2] = BG_SBB(bg_screenblock(2)) | BG_REG_32x32;
+    bg_cnt[3] = BG_SBB(bg_screenblock(3)) | BG_REG_32x32;
 
     if (gfx_ctl.enable_obj)
         reg_dispcnt |= DCNT_OBJ;
@@ -1333,4 +1621,31 @@ void gfx_draw_sprite(gfx_draw_sprite_state_s *state, uint spr_idx,
     }
 }
 
-#pragma endregion
\ No newline at end of file
+#pragma endregion
+
+
+
+
+
+
+
+
+
+#ifdef PLATFORM_PC
+const savestate_region_s gfx_savestate_regions[] = {
+    SAVESTATE_REGION(gfx_ctl),
+    SAVESTATE_REGION(gfx_oam_buffer),
+    SAVESTATE_REGION(gfx_mul_palette),
+    SAVESTATE_REGION(last_palette_mul),
+    SAVESTATE_REGION(gfx_palette),
+    SAVESTATE_REGION(bg_scroll_data),
+    SAVESTATE_REGION(map_prefetch),
+    SAVESTATE_REGION(gfx_text_bmp_buf),
+    SAVESTATE_REGION(gfx_text_bmp_dirty_cols),
+    SAVESTATE_REGION(dma_queue_size),
+    SAVESTATE_REGION(dma_queue),
+    SAVESTATE_REGION(dma_cpypool_write),
+    SAVESTATE_REGION(dma_cpypool),
+    SAVESTATE_END
+};
+#endif
@@ -18,7 +18,7 @@
                              + SIZEOF_TILE * 1)
 
 .extern gfx_text_bmp_buf
-.extern gfx_text_bmp_dirty_rows
+.extern gfx_text_bmp_dirty_cols
 
 #else
 #   define GFX_TEXT_BMP_VRAM (&(tile_mem[GFX_TEXT_BMP_BLOCK][1]))
@@ -36,6 +36,7 @@
 #define GFX_BG1_INDEX 29 // foreground/play layer
 #define GFX_BG2_INDEX 30 // mountain parallax (for that one room)
 #define GFX_BG3_INDEX 31 // sky background (for that one room)
+#define GFX_BG1_SPARE_INDEX 27 // for gfx_prefetch_map
 
 #define GFX_CHAR_GAME_TILESET 0
 
@@ -100,6 +101,13 @@ typedef enum gfx_bg_bpp
 }
 gfx_bg_bpp_e;
 
+typedef enum gfx_dma_prio
+{
+    GFX_DMA_PRIO_HIGH, // always done on the next gfx_commit
+    GFX_DMA_PRIO_LOW,  // may be put off to a later frame if vblank is busy
+}
+gfx_dma_prio_e;
+
 typedef struct gfx_frame
 {
     u16 obj_pool_index;
@@ -249,16 +257,24 @@ void gfx_new_frame(void);
 void gfx_commit(void);
 void gfx_load_map(uint bg_idx, const gfx_map_s *map);
 void gfx_mark_scroll_dirty(uint bg_idx);
-static inline void gfx_unload_map(uint bg_idx)
-{
-    gfx_ctl.bg[bg_idx].map = (gfx_map_s){0};
-    gfx_ctl.bg[bg_idx].map_width = 0;
-    gfx_ctl.bg[bg_idx].map_height = 0;
-}
-
+void gfx_unload_map(uint bg_idx);
+
+// draws the first screen of a map that's about to be loaded into a spare
+// screenblock, ahead of time. if the bg ends up scrolled to the same offset
+// once gfx_load_map is called with it, the bg switches over to that
+// screenblock instead of drawing the whole screen on that frame. only bg 1
+// has a spare screenblock.
+void gfx_prefetch_map(uint bg_idx, const gfx_map_s *map,
+                      int offset_x, int offset_y);
+
+// copies queued up to be done by dma during the next vblank, in the order they
+// were queued. sizes have to be even, since vram can't be written to a byte at
+// a time. the source of a low-priority copy has to stay valid until it's
+// actually been done, which buffers from gfx_alloc_cpybuf will.
 void* gfx_alloc_cpybuf(size_t size);
-bool gfx_queue_memcpy(void *dst, const void *src, size_t size);
-bool gfx_queue_memset(void *dst, u8 value, size_t size);
+bool gfx_queue_memcpy(void *dst, const void *src, size_t size,
+                      gfx_dma_prio_e prio);
+bool gfx_queue_memset(void *dst, u8 value, size_t size, gfx_dma_prio_e prio);
 
 void gfx_set_palette_mode(gfx_pal_mode_e mode);
 
@@ -3,7 +3,7 @@
 #include <tonc.h>
 #include "gfx.h"
 
-extern bool gfx_text_bmp_dirty_rows[GFX_TEXT_BMP_ROWS];
+extern u32 gfx_text_bmp_dirty_cols[GFX_TEXT_BMP_ROWS + 2];
 
 void _gfx_text_blit_tile(uint x, uint y, const TILE4 *src_tile)
 {
@@ -45,10 +45,12 @@ void gfx_text_bmap_fill(uint oc, uint or, uint cols, uint rows, u32 data[8])
 {
     if (cols == 0 || rows == 0) return;
 
+    const u32 dirty_mask = ((1u << cols) - 1) << oc;
+
     TILE *tile = gfx_text_bmp_buf + (GFX_TEXT_BMP_COLS * or + oc);
     for (uint ri = 0; ri < rows; ++ri)
     {
-        gfx_text_bmp_dirty_rows[or] = 1;
+        gfx_text_bmp_dirty_cols[or] |= dirty_mask;
         
         u32 *write = tile->data;
         for (uint ci = cols; ci != 0; --ci)
@@ -244,8 +244,15 @@ gfx_text_bmap_fill:
     @ r4 = data param
     ldr r4, [ip]
 
-    @ r11 = row ypos
-    mov r11, r1
+    @ ip: pointer to this row's gfx_text_bmp_dirty_cols entry
+    ldr ip, =gfx_text_bmp_dirty_cols
+    add ip, ip, r1, lsl #2
+
+    @ r11: dirty mask, ((1 << cols) - 1) << oc
+    mov r11, #1
+    lsl r11, r11, r2
+    sub r11, #1
+    lsl r11, r11, r0
 
     @ r0 = param oc
     @ r1 = tile ptr (derived from param or)
@@ -266,14 +273,12 @@ gfx_text_bmap_fill:
     @ r0: tile row origin
     mov r0, r1
 
-    @ ip: pointer to gfx_text_bmp_dirty_rows
-    ldr ip, =gfx_text_bmp_dirty_rows
-
 1: @ row loop
-    @ flag row as dirty
+    @ flag the columns as dirty
     @ (r6: temp)
-    mov r6, #1
-    strb r6, [ip, r11]
+    ldr r6, [ip]
+    orr r6, r11
+    str r6, [ip], #4
 
     @ r5: dec col counter
     mov r5, r2
@@ -293,7 +298,6 @@ gfx_text_bmap_fill:
 
     @ end of row_loop
     add r0, r10
-    add r11, #1
     mov r1, r0
     subs r3, #1
     bne 1b
@@ -0,0 +1,74 @@
+#include <tonc.h>
+#include <platutil.h>
+
+#include "lz77.h"
+
+void lz77_decompress(const void *src, void *dst)
+{
+#ifdef PLATFORM_GBA
+    LZ77UnCompWram(src, dst);
+#else
+    lz77_stream_s s;
+    lz77_stream_init(&s, src, dst);
+    lz77_stream_run(&s, lz77_decompressed_size(src));
+#endif
+}
+
+void lz77_stream_init(lz77_stream_s *s, const void *src, void *dst)
+{
+    *s = (lz77_stream_s)
+    {
+        .src = (const u8 *)src + 4,
+        .dst = dst,
+        .dst_start = dst,
+        .dst_end = (u8 *)dst + lz77_decompressed_size(src),
+        .flags = 0,
+        .flags_left = 0,
+    };
+}
+
+ARM_FUNC
+size_t lz77_stream_run(lz77_stream_s *s, size_t size)
+{
+    const u8 *src = s->src;
+    u8 *dst = s->dst;
+    u8 *const end = (s->dst_start + size < s->dst_end)
+                    ? s->dst_start + size : s->dst_end;
+
+    uint flags = s->flags;
+    uint flags_left = s->flags_left;
+
+    while (dst < end)
+    {
+        if (flags_left == 0)
+        {
+            flags = *src++;
+            flags_left = 8;
+        }
+
+        if (flags & 0x80)
+        {
+            // copies never run past the end of the data, so this doesn't
+            // have to check against dst_end
+            const uint v = (src[0] << 8) | src[1];
+            src += 2;
+
+            const u8 *from = dst - (v & 0xFFF) - 1;
+            for (uint n = (v >> 12) + 3; n > 0; --n)
+                *dst++ = *from++;
+        }
+        else
+        {
+            *dst++ = *src++;
+        }
+
+        flags <<= 1;
+        --flags_left;
+    }
+
+    s->src = src;
+    s->dst = dst;
+    s->flags = flags;
+    s->flags_left = flags_left;
+    return (size_t)(dst - s->dst_start);
+}
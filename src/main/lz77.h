@@ -0,0 +1,39 @@
+#ifndef LZ77_H
+#define LZ77_H
+
+#include <tonc_types.h>
+#include <stddef.h>
+
+// decompression of the gba bios lz77 format (type 0x10), as written by
+// tools/lz77.py. the data has to be word-aligned.
+//
+// the bios can only decompress everything in one go, so there's also a
+// stream that decompresses a bit at a time, for spreading the work out over
+// several frames.
+
+typedef struct lz77_stream
+{
+    const u8 *src;
+    u8 *dst;
+    u8 *dst_start;
+    u8 *dst_end;
+    uint flags;      // flag byte of the current block, shifted as it's used
+    uint flags_left; // tokens left in the current block
+}
+lz77_stream_s;
+
+static inline size_t lz77_decompressed_size(const void *src)
+{
+    return *(const u32 *)src >> 8;
+}
+
+// decompresses all of src into dst
+void lz77_decompress(const void *src, void *dst);
+
+void lz77_stream_init(lz77_stream_s *s, const void *src, void *dst);
+
+// decompresses until at least size bytes of dst have been written in total,
+// or all of it has. returns how many bytes have been written so far.
+size_t lz77_stream_run(lz77_stream_s *s, size_t size);
+
+#endif
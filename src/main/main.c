@@ -5,6 +5,7 @@
 #include <log.h>
 
 #include "gfx.h"
+#include "savestate.h"
 #include "scenes.h"
 #include "sound.h"
 
@@ -45,3 +46,18 @@ void platform_app_frame(void)
     LOG_DBG("frame usage: %.1f%%", (float)frame_len / 280896.f * 100.f);
     #endif
 }
+
+#ifdef PLATFORM_PC
+// run-ahead only covers the game scene. the other scenes are menus, so there's
+// nothing to gain there, and their state isn't in the snapshot.
+bool platform_app_save_state(void)
+{
+    if (scenemgr_current != &scene_desc_game) return false;
+    return savestate_save();
+}
+
+void platform_app_load_state(void)
+{
+    savestate_load();
+}
+#endif
@@ -11,19 +11,72 @@ typedef struct mapc_header
     u16 width;
     u16 height;
     u8  bg_id; // 0: black; 1: outdoors
+    u8  flags; // MAPC_FLAG_*
 
-    // 3 bytes padding
+    // 2 bytes padding
     
     u32 col_data_offset;
     u32 gfx_data_offset;
     u32 ent_data_offset;
 } mapc_header_s;
 
+// the collision and graphics sections are lz77-compressed (see lz77.h). the
+// flags have to match MAPC_FLAG_* in tools/mapc.py.
+#define MAPC_FLAG_LZ77 1
+
+// entity types. the numbering has to match ENTITY_TYPES in tools/mapc.py.
+typedef enum mapc_ent_type
+{
+    MAPC_ENT_PLAYER,
+    MAPC_ENT_CRAWLER,
+    MAPC_ENT_GUN_ENEMY,
+    MAPC_ENT_CEIL_GUN_ENEMY,
+    MAPC_ENT_ICE_BLOCK,
+    MAPC_ENT_SPRING,
+    MAPC_ENT_SUPER_SPRING,
+    MAPC_ENT_HOME,
+    MAPC_ENT_SIGN,
+    MAPC_ENT_HINT_SIGN,
+    MAPC_ENT_WATER_TANK,
+    MAPC_ENT_STATIC_FRAGILE_BLOCK,
+    MAPC_ENT_RED_ORB,
+    MAPC_ENT_BLUE_ORB,
+    MAPC_ENT_STALACTITE,
+    MAPC_ENT_BOSS,
+} mapc_ent_type_e;
+
+// an entity placed in the map. mapc resolves the tiled properties that the
+// entity type uses into arg, so there's nothing to look up when spawning:
+//   crawler      max_dist in tiles, as a FIXED
+//   gun enemies  GUN_ENEMY_DIRFLAG_* from fire_dir
+//   signs        index of the dialogue chat named by text, or -1
+//   stalactite   variant
+//   the rest     0
+typedef struct mapc_spawn
+{
+    u8 type; // mapc_ent_type_e
+    // 1 byte padding
+    s16 x, y;
+    s16 w, h;
+    // 2 bytes padding
+    s32 arg;
+} mapc_spawn_s;
+
+// the entity section is a u16 count, 2 bytes padding, then that many
+// mapc_spawn_s.
+typedef struct mapc_ent_data
+{
+    u16 count;
+    // 2 bytes padding
+    mapc_spawn_s spawns[];
+} mapc_ent_data_s;
+
 static inline const u8* mapc_collision_data(const mapc_header_s *header)
 {
     return (const u8 *)((uintptr_t)header + header->col_data_offset);
 }
 
+// size of the collision data once it's decompressed
 static inline uint mapc_collision_data_size(const mapc_header_s *header)
 {
     return CEIL_DIV((uint)header->width * (uint)header->height, 4);
@@ -34,10 +87,12 @@ static inline const u16* mapc_graphics_data(const mapc_header_s *header)
     return (const u16 *)((uintptr_t)header + header->gfx_data_offset);
 }
 
-static inline const u8* mapc_entity_data(const mapc_header_s *header)
+static inline const mapc_ent_data_s* mapc_entity_data(
+    const mapc_header_s *header)
 {
     if (header->ent_data_offset == 0) return NULL;
-    return (const u8 *)((uintptr_t)header + header->ent_data_offset);
+    return (const mapc_ent_data_s *)((uintptr_t)header +
+                                     header->ent_data_offset);
 }
 
 static inline int mapc_collision_get(const u8 *data, uint pitch, uint x, uint y)
@@ -40,6 +40,19 @@ static inline uint upair2u(uint a, uint b)
     return ((x * x + x) >> 1) + y;
 }
 
+// index of the lowest set bit. x must not be zero.
+// the gba's cpu doesn't have a clz instruction, so __builtin_ctz would end up
+// calling into libgcc. a de bruijn multiply is just a multiply and a load.
+static inline int bit_ctz32(u32 x)
+{
+    static const u8 table[32] = {
+        0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+        31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+    };
+
+    return table[((x & -x) * 0x077CB531u) >> 27];
+}
+
 // t is an integer [0, 256]
 // [0, 256] => [0, 2PI]
 static inline FIXED sine_lut(uint t)
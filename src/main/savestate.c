@@ -0,0 +1,91 @@
+#ifdef PLATFORM_PC
+
+#include <string.h>
+#include <tonc.h>
+#include <modplay.h>
+#include <log.h>
+
+#include "savestate.h"
+#include "game_rewind.h"
+
+// big enough for everything listed below, with room to grow
+#define SAVESTATE_BUFFER_SIZE (512 * 1024)
+
+// these are defined next to the state they cover
+extern const savestate_region_s game_savestate_regions[];
+extern const savestate_region_s game_physics_savestate_regions[];
+extern const savestate_region_s game_rewind_savestate_regions[];
+extern const savestate_region_s gfx_savestate_regions[];
+extern const savestate_region_s snd_savestate_regions[];
+extern const savestate_region_s scenemgr_savestate_regions[];
+extern const savestate_region_s scene_game_savestate_regions[];
+
+// the emulated hardware. the io registers include the sound registers, which
+// the audio is rendered from.
+static const savestate_region_s hw_savestate_regions[] = {
+    SAVESTATE_REGION(tonc__mem_io),
+    SAVESTATE_REGION(tonc__mem_pal),
+    SAVESTATE_REGION(tonc__mem_vram),
+    SAVESTATE_REGION(tonc__mem_oam),
+    SAVESTATE_REGION(__key_curr),
+    SAVESTATE_REGION(__key_prev),
+    SAVESTATE_END
+};
+
+static const savestate_region_s *const region_tables[] = {
+    hw_savestate_regions,
+    game_savestate_regions,
+    game_physics_savestate_regions,
+    game_rewind_savestate_regions,
+    gfx_savestate_regions,
+    snd_savestate_regions,
+    scenemgr_savestate_regions,
+    scene_game_savestate_regions,
+};
+
+#define REGION_TABLE_COUNT (sizeof(region_tables) / sizeof(*region_tables))
+
+static u8 savestate_buf[SAVESTATE_BUFFER_SIZE];
+
+bool savestate_save(void)
+{
+    u8 *p = savestate_buf;
+
+    for (size_t i = 0; i < REGION_TABLE_COUNT; ++i)
+    {
+        for (const savestate_region_s *r = region_tables[i]; r->ptr; ++r)
+        {
+            if (p + r->size > savestate_buf + SAVESTATE_BUFFER_SIZE)
+            {
+                LOG_ERR("savestate_save: state too large for buffer!");
+                return false;
+            }
+
+            memcpy(p, r->ptr, r->size);
+            p += r->size;
+        }
+    }
+
+    mplay_set_locked(true);
+    game_rewind_set_locked(true);
+    return true;
+}
+
+void savestate_load(void)
+{
+    const u8 *p = savestate_buf;
+
+    for (size_t i = 0; i < REGION_TABLE_COUNT; ++i)
+    {
+        for (const savestate_region_s *r = region_tables[i]; r->ptr; ++r)
+        {
+            memcpy(r->ptr, p, r->size);
+            p += r->size;
+        }
+    }
+
+    mplay_set_locked(false);
+    game_rewind_set_locked(false);
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// snapshots of everything that changes while playing, for the pc build's
+// run-ahead. each module lists its state in a table of regions, ending with
+// SAVESTATE_END, and a snapshot is just a copy of all of them.
+//
+// anything that a snapshot can't undo, like music playback or the rewind
+// history, gets locked while frames that will be thrown away are running.
+
+typedef struct savestate_region
+{
+    void *ptr;
+    size_t size;
+}
+savestate_region_s;
+
+#define SAVESTATE_REGION(var) { &(var), sizeof(var) }
+#define SAVESTATE_END { NULL, 0 }
+
+#ifdef PLATFORM_PC
+// takes a snapshot, and locks everything it can't undo until the next
+// savestate_load. returns false if the state didn't fit in the buffer, in
+// which case nothing is locked.
+bool savestate_save(void);
+void savestate_load(void);
+#endif
+
+#endif
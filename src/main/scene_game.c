@@ -18,6 +18,7 @@
 #include "automap.h"
 #include "math_util.h"
 #include "options_menu.h"
+#include "savestate.h"
 
 //------------------------------------------------------------------------------
 // declarations
@@ -705,4 +706,11 @@ const scene_desc_s scene_desc_game = {
     .frame = scene_frame
 };
 
+#ifdef PLATFORM_PC
+const savestate_region_s scene_game_savestate_regions[] = {
+    SAVESTATE_REGION(state),
+    SAVESTATE_END
+};
+#endif
+
 #pragma endregion lifecycle
\ No newline at end of file
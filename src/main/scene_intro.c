@@ -58,8 +58,11 @@ static void update_image(void)
         default: return;
     }
 
-    gfx_queue_memcpy(&tile_mem[0], tile_data, tile_sz);
-    gfx_queue_memcpy(&se_mem[GFX_BG1_INDEX][0], map_data, map_sz);
+    // new pages come in while the screen is faded out, so it doesn't matter
+    // if these are a frame late
+    gfx_queue_memcpy(&tile_mem[0], tile_data, tile_sz, GFX_DMA_PRIO_LOW);
+    gfx_queue_memcpy(&se_mem[GFX_BG1_INDEX][0], map_data, map_sz,
+                     GFX_DMA_PRIO_LOW);
 
 #undef CASE
 
@@ -81,7 +84,8 @@ static void scene_load(uintptr_t init_data)
     gfx_ctl.bg[0].offset_x = -8;
     gfx_ctl.bg[0].offset_y = -4;
 
-    gfx_queue_memset(&se_mem[GFX_BG1_INDEX][0], 0, sizeof(SCREENBLOCK));
+    gfx_queue_memset(&se_mem[GFX_BG1_INDEX][0], 0, sizeof(SCREENBLOCK),
+                     GFX_DMA_PRIO_HIGH);
 
     gfx_text_bmap_dst_assign(13, TEXT_ROW_COUNT, 0, GFX_TEXTPAL_NORMAL);
 
@@ -76,9 +76,9 @@ static void scene_load(uintptr_t data)
     gfx_text_bmap_dst_assign(SCREEN_HEIGHT_T / 2, GFX_TEXT_BMP_ROWS, 0,
                                 GFX_TEXTPAL_NORMAL);
 
-    gfx_queue_memset(se_mem[GFX_BG1_INDEX], 0, 1024 * 2);
+    gfx_queue_memset(se_mem[GFX_BG1_INDEX], 0, 1024 * 2, GFX_DMA_PRIO_HIGH);
     gfx_queue_memcpy(&tile_mem[0][0].data, game_logo_gfxTiles,
-                    game_logo_gfxTilesLen);
+                    game_logo_gfxTilesLen, GFX_DMA_PRIO_HIGH);
     
     const SCR_ENTRY *src = (const SCR_ENTRY *)game_logo_gfxMap;
     uint oy = 2;
@@ -93,7 +93,8 @@ static void scene_load(uintptr_t data)
         for (uint i = 0; i < 22; ++i)
             row[i] = *(src++);
 
-        gfx_queue_memcpy(&se_mat[GFX_BG1_INDEX][y][ox], row, alloc_size);
+        gfx_queue_memcpy(&se_mat[GFX_BG1_INDEX][y][ox], row, alloc_size,
+                         GFX_DMA_PRIO_HIGH);
         // for (uint x = ox; x < ox + 22; ++x)
         // {
         //     se_mat[GFX_BG1_INDEX][y][x] = *(src++);
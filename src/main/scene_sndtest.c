@@ -43,7 +43,8 @@ static void scene_load(uintptr_t init_data)
 {
     selected_sound = 0;
 
-    gfx_queue_memset(&se_mem[GFX_BG1_INDEX][0], 0, sizeof(SCREENBLOCK));
+    gfx_queue_memset(&se_mem[GFX_BG1_INDEX][0], 0, sizeof(SCREENBLOCK),
+                     GFX_DMA_PRIO_HIGH);
     gfx_text_bmap_dst_assign(0, 5, 0, GFX_TEXTPAL_NORMAL);
     gfx_text_bmap_clear(0, 0, GFX_TEXT_BMP_COLS, 5);
 
@@ -1,4 +1,5 @@
 #include "scenes.h"
+#include "savestate.h"
 #include <stddef.h>
 #include <stdbool.h>
 
@@ -44,4 +45,12 @@ void scenemgr_frame(void)
 
     if (scenemgr_current && scenemgr_current->frame)
         scenemgr_current->frame();
-}
\ No newline at end of file
+}
+
+#ifdef PLATFORM_PC
+const savestate_region_s scenemgr_savestate_regions[] = {
+    SAVESTATE_REGION(scenemgr_current),
+    SAVESTATE_REGION(scene_change_data),
+    SAVESTATE_END
+};
+#endif
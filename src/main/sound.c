@@ -9,6 +9,7 @@
 #include <data/wave_noise_bin.h>
 
 #include "math_util.h"
+#include "savestate.h"
 #include "sound.h"
 #include "sound_table.h"
 
@@ -391,4 +392,14 @@ static void apply_tick(uint frame_tick_idx)
     REG_SND3FREQ  = reg_freq_vals[2][frame_tick_idx];
     REG_SND4CNT   = reg_ctl_vals[3][frame_tick_idx];
     REG_SND4FREQ  = reg_freq_vals[3][frame_tick_idx];
-}
\ No newline at end of file
+}
+
+// only the slots change from the game's side. the rest is worked out while
+// the audio is rendered.
+#ifdef PLATFORM_PC
+const savestate_region_s snd_savestate_regions[] = {
+    SAVESTATE_REGION(snd_slots),
+    SAVESTATE_REGION(next_snd_slot),
+    SAVESTATE_END
+};
+#endif
@@ -34,6 +34,7 @@ static mp_bool s_main_loop;
 static mp_uint s_sample_rate = 48000;
 static mp_size s_alloc_size = 0;
 static mp_s8 *s_alloc = NULL;
+static mp_bool s_locked = false;
 
 
 static xmp_context load_module(mp_uint module_id)
@@ -98,6 +99,8 @@ void mplay_deinit(void)
 
 void mplay_start(mp_uint module_id, mp_bool loop)
 {
+    if (s_locked) return;
+
     s_main_xmpc = load_module(module_id);
     
     if (!s_main_xmpc)
@@ -115,6 +118,11 @@ void mplay_set_sample_rate(mp_uint sample_rate)
     s_sample_rate = sample_rate;
 }
 
+void mplay_set_locked(mp_bool locked)
+{
+    s_locked = locked;
+}
+
 void mplay_render(mp_s16 *data, mp_size frame_count)
 {
     mp_size buffer_size = frame_count * sizeof(*data) * 2;
@@ -177,17 +185,19 @@ void mplay_render(mp_s16 *data, mp_size frame_count)
 
 void mplay_pause(void)
 {
+    if (s_locked) return;
     s_main_paused = true;
 }
 
 void mplay_resume(void)
 {
+    if (s_locked) return;
     s_main_paused = false;
 }
 
 void mplay_stop(void)
 {
-    if (!s_main_xmpc) return;
+    if (s_locked || !s_main_xmpc) return;
 
     xmp_end_player(s_main_xmpc);
     xmp_free_context(s_main_xmpc);
@@ -201,12 +211,15 @@ bool mplay_is_active(void)
 
 void mplay_set_volume(mp_uint volume)
 {
+    if (s_locked) return;
     // if (volume > VOLUME_SCALE) volume = VOLUME_SCALE;
     s_main_volume = volume;
 }
 
 void mplay_sub_start(mp_uint module_id)
 {
+    if (s_locked) return;
+
     s_sub_xmpc = load_module(module_id);
     
     if (!s_sub_xmpc)
@@ -221,10 +234,12 @@ void mplay_sub_start(mp_uint module_id)
 
 void mplay_set_sub_volume(mp_uint volume)
 {
+    if (s_locked) return;
     s_sub_volume = volume;
 }
 
 void mplay_set_event_handler(mplay_event_handler_f handler)
 {
+    if (s_locked) return;
     s_ev_handler = handler;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <log.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define SDL_MAIN_USE_CALLBACKS 1
 #include <SDL3/SDL.h>
@@ -40,10 +41,13 @@
 #define SECS(x) (s64)((x) * 1000000000)
 #define FRAME_LENGTH_NS SECS(1.0 / 60.0)
 #define DT_SNAP_THRESH  SECS(0.002)
+#define MAX_RUN_AHEAD   4
 
 // these functions are defined by src/main/main.c
 void platform_app_init(void);
 void platform_app_frame(void);
+bool platform_app_save_state(void);
+void platform_app_load_state(void);
 
 static SDL_Window *s_window = NULL;
 static SDL_AudioStream *s_astream = NULL;
@@ -56,6 +60,16 @@ static double s_asamp_accum[2] = { 0.0, 0.0 };
 
 static uint s_key_input = 0x3FF;
 
+// if not NULL, REG_KEYINPUT is written here every frame as a little-endian
+// u16. can be replayed with the headless runner.
+static FILE *s_input_record = NULL;
+
+// number of frames to simulate past the real one before presenting. the game
+// only shows a frame's changes on the frame after, and displays add their own
+// latency on top of that. running ahead with the current input and showing
+// that frame instead hides it.
+static int s_run_ahead = 0;
+
 struct gfx_state
 {
     GLuint screen_tex;
@@ -621,6 +635,22 @@ SDL_AppResult SDL_AppInit(void **appstate, int argc, char *argv[])
         return SDL_APP_FAILURE;
     }
 
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--record") && i + 1 < argc)
+        {
+            const char *path = argv[++i];
+            s_input_record = fopen(path, "wb");
+            if (!s_input_record)
+                SDL_Log("Couldn't open %s for input recording", path);
+        }
+        else if (!strcmp(argv[i], "--run-ahead") && i + 1 < argc)
+        {
+            s_run_ahead = SDL_atoi(argv[++i]);
+            s_run_ahead = CLAMP(s_run_ahead, 0, MAX_RUN_AHEAD + 1);
+        }
+    }
+
 #ifdef GL_DESKTOP
     if (!gladLoadGLLoader((void *)SDL_GL_GetProcAddress))
     {
@@ -708,6 +738,13 @@ SDL_AppResult SDL_AppIterate(void *appstate)
     {
         if (s_time_accum < FRAME_LENGTH_NS) break;
 
+        if (s_input_record)
+        {
+            u16 keys = REG_KEYINPUT;
+            u8 b[2] = { keys & 0xFF, keys >> 8 };
+            fwrite(b, 1, 2, s_input_record);
+        }
+
         platform_app_frame();
     
         did_update = true;
@@ -718,9 +755,20 @@ SDL_AppResult SDL_AppIterate(void *appstate)
 
     if (did_update)
     {
+        // the frames run ahead are thrown away once the last one is shown
+        bool ran_ahead = s_run_ahead > 0 && platform_app_save_state();
+        if (ran_ahead)
+        {
+            for (int i = 0; i < s_run_ahead; ++i)
+                platform_app_frame();
+        }
+
         g_display_buffer = s_gfx_state.screen_pixels;
         display_update();
 
+        if (ran_ahead)
+            platform_app_load_state();
+
         glBindTexture(GL_TEXTURE_2D, s_gfx_state.screen_tex);
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT,
                         GL_RGBA, GL_UNSIGNED_BYTE, s_gfx_state.screen_pixels);    
@@ -823,6 +871,9 @@ void SDL_AppQuit(void *appstate, SDL_AppResult result)
 {
     SDL_CloseGamepad(s_gamepad);
 
+    if (s_input_record)
+        fclose(s_input_record);
+
     glDeleteTextures(1, &s_gfx_state.screen_tex);
     glDeleteBuffers(1, &s_gfx_state.display_quad);
     glDeleteBuffers(1, &s_gfx_state.display_quad);
@@ -0,0 +1,462 @@
+// physics stress benchmark. builds a synthetic room, fills it with a growing
+// number of bodies for a few scenarios, and times game_update and the physics
+// stages for each. results are written as csv to stdout, so that runs from
+// before and after a physics change can be compared.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <log.h>
+
+#include <tonc.h>
+#include <platctl.h>
+
+#include "game.h"
+#include "game_physics.h"
+#include "mapc.h"
+
+#ifndef PHYS_PROFILE
+#error "physbench needs to be compiled with PHYS_PROFILE"
+#endif
+
+#define ROOM_WIDTH  160
+#define ROOM_HEIGHT 22
+
+#define WARMUP_FRAMES 60
+#define DEFAULT_FRAMES 600
+
+#define HEAD_BUMP_COLUMN_HEIGHT 4
+#define HEAD_BUMP_PERIOD 45
+
+#define STACK_COLUMN_HEIGHT 8
+
+// in tiles, including the walls
+#define PLAYER_POCKET_SIZE 4
+
+typedef struct bench_room_data
+{
+    mapc_header_s header;
+    u8 col[CEIL_DIV(ROOM_WIDTH * ROOM_HEIGHT, 4)];
+    // never rendered, but game_load_room wants a graphics pointer anyway
+    u16 gfx[ROOM_WIDTH * ROOM_HEIGHT];
+}
+bench_room_data_s;
+
+typedef struct bench_result
+{
+    int entity_count;
+    int projectile_count;
+    u64 frame_ns;
+    u64 phys_ns;
+    u64 detect_ent_ns;
+    u64 detect_tile_ns;
+    u64 resolve_ns;
+    u64 contacts;
+    u64 iterations;
+    u64 warm_contacts;
+    u64 sleeping;
+}
+bench_result_s;
+
+typedef void (*scenario_spawn_f)(int n);
+typedef void (*scenario_frame_f)(int frame);
+
+typedef struct scenario
+{
+    const char *name;
+    scenario_spawn_f spawn;
+    scenario_frame_f frame; // may be NULL
+}
+scenario_s;
+
+static bench_room_data_s s_room_data;
+static world_room_s s_room;
+
+
+
+
+
+
+
+
+
+
+//------------------------------------------------------------------------------
+// platctl
+//------------------------------------------------------------------------------
+#pragma region platctl
+
+void platctl_set_volume(unsigned int volume) {}
+void platctl_set_fullscreen(bool fulscr) {}
+bool platctl_get_fullscreen(void) { return false; }
+void platctl_set_fullscreen_change_watcher(platctl_fulscr_change_watcher_f fun)
+{}
+
+#pragma endregion platctl
+
+
+
+
+
+
+
+
+
+
+//------------------------------------------------------------------------------
+// room
+//------------------------------------------------------------------------------
+#pragma region room
+
+static void room_set_col(int x, int y, int cell)
+{
+    uint i = (uint)y * ROOM_WIDTH + (uint)x;
+    u8 *b = s_room_data.col + (i >> 2);
+    *b = (*b & ~(0x3 << ((i & 0x3) << 1))) | (cell << ((i & 0x3) << 1));
+}
+
+// a closed box: solid floor, ceiling and walls, empty inside except for a
+// sealed pocket in the top-left corner, which is where game_init puts the
+// player. that way stray projectiles can't kill it and restart the run.
+static void room_build(void)
+{
+    memset(&s_room_data, 0, sizeof(s_room_data));
+
+    s_room_data.header = (mapc_header_s)
+    {
+        .width = ROOM_WIDTH,
+        .height = ROOM_HEIGHT,
+        .bg_id = 0,
+        .col_data_offset = offsetof(bench_room_data_s, col),
+        .gfx_data_offset = offsetof(bench_room_data_s, gfx),
+        .ent_data_offset = 0
+    };
+
+    for (int x = 0; x < ROOM_WIDTH; ++x)
+    {
+        room_set_col(x, 0, 1);
+        room_set_col(x, ROOM_HEIGHT - 1, 1);
+    }
+
+    for (int y = 0; y < ROOM_HEIGHT; ++y)
+    {
+        room_set_col(0, y, 1);
+        room_set_col(ROOM_WIDTH - 1, y, 1);
+    }
+
+    for (int i = 1; i <= PLAYER_POCKET_SIZE; ++i)
+    {
+        room_set_col(PLAYER_POCKET_SIZE, i, 1);
+        room_set_col(i, PLAYER_POCKET_SIZE, 1);
+    }
+
+    s_room = (world_room_s)
+    {
+        .x = 0,
+        .y = 0,
+        // no music
+        .music = UINT8_MAX,
+        .map = &s_room_data.header
+    };
+}
+
+#pragma endregion room
+
+
+
+
+
+
+
+
+
+
+//------------------------------------------------------------------------------
+// scenarios
+//------------------------------------------------------------------------------
+#pragma region scenarios
+
+// keep clear of the player pocket
+#define SPAWN_X0 8
+#define FLOOR_Y (ROOM_HEIGHT - 2)
+
+static entity_s* spawn(void)
+{
+    return entity_alloc();
+}
+
+// columns of ice blocks resting on each other and on their neighbours
+static void ice_stack_spawn(int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        entity_s *ent = spawn();
+        if (!ent) return;
+
+        int cx = SPAWN_X0 + i / STACK_COLUMN_HEIGHT;
+        int cy = FLOOR_Y - i % STACK_COLUMN_HEIGHT;
+        entity_ice_block_init(ent, int2fx(cx * WORLD_TILE_SIZE),
+                              int2fx(cy * WORLD_TILE_SIZE));
+    }
+}
+
+// bottom blocks of the head bump columns. kept here instead of going by the
+// head bump flag, since that's physics state and not ours to use as a marker
+static entity_s *s_head_bump_bodies[MAX_ENTITY_COUNT];
+static int s_head_bump_count;
+
+// short columns of ice blocks, spaced apart, whose bottom block gets kicked
+// upwards every so often
+static void head_bump_spawn(int n)
+{
+    s_head_bump_count = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        entity_s *ent = spawn();
+        if (!ent) return;
+
+        int row = i % HEAD_BUMP_COLUMN_HEIGHT;
+        int cx = SPAWN_X0 + (i / HEAD_BUMP_COLUMN_HEIGHT) * 2;
+        int cy = FLOOR_Y - row;
+        entity_ice_block_init(ent, int2fx(cx * WORLD_TILE_SIZE),
+                              int2fx(cy * WORLD_TILE_SIZE));
+
+        if (row == 0)
+        {
+            ent->col.flags |= COL_FLAG_HEAD_BUMP;
+            s_head_bump_bodies[s_head_bump_count++] = ent;
+        }
+    }
+}
+
+static void head_bump_frame(int frame)
+{
+    if (frame % HEAD_BUMP_PERIOD != 0) return;
+
+    for (int i = 0; i < s_head_bump_count; ++i)
+    {
+        entity_s *ent = s_head_bump_bodies[i];
+        if (ENTITY_ENABLED(ent))
+            ent->vel.y = -FX(3);
+    }
+}
+
+// gun enemies along the floor, shooting in every direction
+static void proj_storm_spawn(int n)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        entity_s *ent = spawn();
+        if (!ent) return;
+
+        int cx = SPAWN_X0 + (i * 3) % (ROOM_WIDTH - SPAWN_X0 - 2);
+        entity_gun_enemy_init(ent, int2fx(cx * WORLD_TILE_SIZE),
+                              int2fx(FLOOR_Y * WORLD_TILE_SIZE), false,
+                              GUN_ENEMY_DIRFLAG_ALL);
+    }
+}
+
+// the boss, with the remaining slots used up by stalactites on the ceiling
+static void boss_spawn(int n)
+{
+    entity_s *boss = spawn();
+    if (!boss) return;
+    entity_boss_init(boss, int2fx(32 * WORLD_TILE_SIZE),
+                     int2fx((FLOOR_Y - 1) * WORLD_TILE_SIZE));
+
+    for (int i = 0; i < n; ++i)
+    {
+        entity_s *ent = spawn();
+        if (!ent) return;
+
+        int cx = 16 + i % (ROOM_WIDTH - 32);
+        entity_stalactite_init(ent, int2fx(cx * WORLD_TILE_SIZE),
+                               int2fx(1 * WORLD_TILE_SIZE), 1 + i % 2);
+    }
+}
+
+static const scenario_s scenarios[] = {
+    { "ice_stack",  ice_stack_spawn,  NULL },
+    { "head_bump",  head_bump_spawn,  head_bump_frame },
+    { "proj_storm", proj_storm_spawn, NULL },
+    { "boss",       boss_spawn,       NULL },
+};
+
+#define SCENARIO_COUNT ((int)(sizeof(scenarios) / sizeof(*scenarios)))
+
+#pragma endregion scenarios
+
+
+
+
+
+
+
+
+
+
+//------------------------------------------------------------------------------
+// lifecycle
+//------------------------------------------------------------------------------
+#pragma region lifecycle
+
+static u64 get_ticks_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u64)ts.tv_sec * 1000000000ull + (u64)ts.tv_nsec;
+}
+
+static int count_entities(void)
+{
+    int count = 0;
+    for (int i = 0; i < MAX_ENTITY_COUNT; ++i)
+        if (ENTITY_ENABLED(g_game.entities + i)) ++count;
+
+    return count;
+}
+
+static int count_projectiles(void)
+{
+    int count = 0;
+    for (int i = 0; i < MAX_PROJECTILE_COUNT; ++i)
+        if (IS_PROJ_ACTIVE(g_game.projectiles + i)) ++count;
+
+    return count;
+}
+
+static bench_result_s run_scenario(const scenario_s *scenario, int n,
+                                   int frames)
+{
+    game_init();
+    game_load_room(&s_room);
+    scenario->spawn(n);
+    game_save_state();
+
+    bench_result_s res = {0};
+    int entity_sum = 0;
+    int proj_sum = 0;
+
+    for (int frame = 0; frame < WARMUP_FRAMES + frames; ++frame)
+    {
+        if (scenario->frame)
+            scenario->frame(frame);
+
+        u64 start_time = get_ticks_ns();
+        game_update();
+        u64 frame_time = get_ticks_ns() - start_time;
+
+        if (frame < WARMUP_FRAMES) continue;
+
+        const game_physics_profile_s *prof = &game_physics_profile;
+        res.frame_ns += frame_time;
+        // the profile timer doesn't nest, so there is no single
+        // measurement of the whole physics update. sum up the stages instead.
+        res.phys_ns += prof->detection_ent_t + prof->detection_tile_t +
+                       prof->move_t + prof->resolution_t +
+                       prof->projectiles_t;
+        res.detect_ent_ns += prof->detection_ent_t;
+        res.detect_tile_ns += prof->detection_tile_t;
+        res.resolve_ns += prof->resolution_t;
+        res.contacts += prof->contact_count;
+        res.iterations += prof->iteration_count;
+        res.warm_contacts += prof->warm_contact_count;
+        res.sleeping += prof->sleeping_count;
+
+        entity_sum += count_entities();
+        proj_sum += count_projectiles();
+    }
+
+    res.entity_count = (entity_sum + frames / 2) / frames;
+    res.projectile_count = (proj_sum + frames / 2) / frames;
+    return res;
+}
+
+// 1, 2, 4, ... and then however many entity slots there are left
+static int next_body_count(int n)
+{
+    const int max = MAX_ENTITY_COUNT - 1;
+    if (n == max) return max + 1;
+    return (n * 2 < max) ? n * 2 : max;
+}
+
+static void usage(const char *exe)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "options:\n"
+        "  -f <count>    number of timed frames per run (default: %i)\n"
+        "  -s <scenario> only run the given scenario\n"
+        "scenarios:",
+        exe, DEFAULT_FRAMES);
+
+    for (int i = 0; i < SCENARIO_COUNT; ++i)
+        fprintf(stderr, " %s", scenarios[i].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = DEFAULT_FRAMES;
+    const char *only_scenario = NULL;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-f") && i + 1 < argc)
+            frames = (int)strtol(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+            only_scenario = argv[++i];
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (frames <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    LOG_INIT();
+    REG_KEYINPUT = KEY_MASK;
+    room_build();
+
+    printf("scenario,n,entities,projectiles,frames,frame_ns,phys_ns,"
+           "detect_ent_ns,detect_tile_ns,resolve_ns,contacts_per_frame,"
+           "iterations_per_frame,warm_contacts_per_frame,sleeping_per_frame\n");
+
+    for (int s = 0; s < SCENARIO_COUNT; ++s)
+    {
+        const scenario_s *scenario = scenarios + s;
+        if (only_scenario && strcmp(only_scenario, scenario->name)) continue;
+
+        // slot 0 is always the player. the last run fills every other slot.
+        for (int n = 1; n < MAX_ENTITY_COUNT; n = next_body_count(n))
+        {
+            bench_result_s res = run_scenario(scenario, n, frames);
+
+            printf("%s,%i,%i,%i,%i,%llu,%llu,%llu,%llu,%llu,%.2f,%.2f,%.2f,%.2f\n",
+                   scenario->name, n, res.entity_count, res.projectile_count,
+                   frames,
+                   (unsigned long long)(res.frame_ns / frames),
+                   (unsigned long long)(res.phys_ns / frames),
+                   (unsigned long long)(res.detect_ent_ns / frames),
+                   (unsigned long long)(res.detect_tile_ns / frames),
+                   (unsigned long long)(res.resolve_ns / frames),
+                   (double)res.contacts / frames,
+                   (double)res.iterations / frames,
+                   (double)res.warm_contacts / frames,
+                   (double)res.sleeping / frames);
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
+
+#pragma endregion lifecycle
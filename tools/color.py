@@ -128,36 +128,30 @@ def palgen_proc_color(rgb: tuple[float,float,float], smul: float, vmul: float):
     # return (r, g, b)
 
 
-def palgen_proc(colors: list[int], smul: float, vmul: float) -> None:
-    first = True
-
-    for color in colors:
-        if not first:
-            sys.stdout.write(",\n")
-        first = False
-        
-        color = palgen_proc_color(color, smul, vmul)
-        r5g5b5 = rgb_to_r5g5b5(color)
-        str = "0x{:04x}".format(r5g5b5)
-        sys.stdout.write(str)
-    
-    sys.stdout.write("\n")
+def palgen_proc(colors: list[int], smul: float, vmul: float) -> list[int]:
+    return [rgb_to_r5g5b5(palgen_proc_color(color, smul, vmul))
+            for color in colors]
 
 
-def main_palgen(args):
-    if args.mode == 'normal':
-        colors = PICO8_COLORS_NORMAL
-        smul = 1.0
-        vmul = 1.0
-    elif args.mode == 'lcd':
-        colors = PICO8_COLORS_LCD
-        smul = 1.3
-        vmul = 1.2
+# the r5g5b5 palette for each mode, the same as the ones in gfx.c
+def palgen(mode: str) -> list[int]:
+    if mode == 'normal':
+        return palgen_proc(PICO8_COLORS_NORMAL, 1.0, 1.0)
+    elif mode == 'lcd':
+        return palgen_proc(PICO8_COLORS_LCD, 1.3, 1.2)
     else:
-        print("invalid mode", file=sys.stderr)
+        raise Exception(f"invalid mode {mode}")
+
+
+def main_palgen(args):
+    try:
+        palette = palgen(args.mode)
+    except Exception as e:
+        print(e, file=sys.stderr)
         exit(1)
-    
-    palgen_proc(colors, smul, vmul)
+
+    sys.stdout.write(",\n".join("0x{:04x}".format(c) for c in palette))
+    sys.stdout.write("\n")
 
 
 def main_conv(args):
@@ -213,6 +207,35 @@ def main_qlut(args):
             outf.write(struct.pack('<B', n))
 
 
+# the palette for each level of gfx_ctl.palette_mul, from 0 to 256 (FIX_ONE).
+# each color of the normal palette is darkened by the level, the same way the
+# game's fixed-point math would, then snapped back to the closest palette
+# color. what's written out are the palette indices, so the same table works
+# for both palette modes.
+#
+# output is u8[257][16].
+FADE_LEVELS = 257
+
+def main_fadelut(args):
+    normal = palgen('normal')
+    closest: dict[tuple[int, int, int], int] = {}
+
+    with ioutil.open_output(args.out, binary=True) as outf:
+        for level in range(FADE_LEVELS):
+            indices = [0]
+            for color in normal[1:]:
+                r = ((color & 0x1F) * level) >> 8
+                g = (((color >> 5) & 0x1F) * level) >> 8
+                b = (((color >> 10) & 0x1F) * level) >> 8
+
+                if (r, g, b) not in closest:
+                    closest[(r, g, b)] = find_closest_color(
+                        r / 31, g / 31, b / 31, PICO8_COLORS_NORMAL)
+                indices.append(closest[(r, g, b)])
+
+            outf.write(bytes(indices))
+
+
 def main() -> None:
     parser = argparse.ArgumentParser('color')
 
@@ -245,6 +268,14 @@ def main() -> None:
                              default='-')
     parser_qlut.set_defaults(func=main_qlut)
 
+    # fadelut subparser
+    parser_fadelut = subparsers.add_parser('fadelut',
+                                           help='generates the palette for each level of a fade')
+    parser_fadelut.add_argument('-o', '--out',
+                                help='output file. - to write to stdout (default)',
+                                default='-')
+    parser_fadelut.set_defaults(func=main_fadelut)
+
     args = parser.parse_args()
     args.func(args)
     
@@ -0,0 +1,95 @@
+# lz77 compression in the format the gba bios decompresses (type 0x10).
+#
+# the data starts with a u32 header, 0x10 | (decompressed size << 8). after
+# that come blocks of a flag byte followed by 8 tokens, one per flag bit,
+# starting at the most significant. a 0 bit is a literal byte. a 1 bit is a
+# copy of earlier output, stored in two bytes: the high nibble of the first is
+# the length minus 3, and the other 12 bits are the distance back minus 1.
+
+MIN_MATCH = 3
+MAX_MATCH = 18
+MAX_DIST = 4096
+
+def compress(data: bytes) -> bytes:
+    data = bytes(data)
+    out = bytearray()
+    out += (0x10 | (len(data) << 8)).to_bytes(4, 'little')
+
+    # positions where each 3-byte string starts, most recent last
+    chains: dict[bytes, list[int]] = {}
+
+    i = 0
+    flag_pos = -1
+    flag_bit = 0
+    while i < len(data):
+        if flag_bit == 0:
+            flag_pos = len(out)
+            out.append(0)
+            flag_bit = 0x80
+
+        best_len = 0
+        best_dist = 0
+        key = data[i:i+MIN_MATCH]
+        if len(key) == MIN_MATCH:
+            for j in reversed(chains.get(key, [])):
+                dist = i - j
+                if dist > MAX_DIST: break
+
+                n = 0
+                limit = min(MAX_MATCH, len(data) - i)
+                while n < limit and data[j + n] == data[i + n]:
+                    n += 1
+
+                if n > best_len:
+                    best_len = n
+                    best_dist = dist
+                    if n == MAX_MATCH: break
+
+        if best_len >= MIN_MATCH:
+            out[flag_pos] |= flag_bit
+            v = ((best_len - MIN_MATCH) << 12) | (best_dist - 1)
+            out.append(v >> 8)
+            out.append(v & 0xFF)
+            step = best_len
+        else:
+            out.append(data[i])
+            step = 1
+
+        for k in range(i, i + step):
+            chains.setdefault(data[k:k+MIN_MATCH], []).append(k)
+
+        i += step
+        flag_bit >>= 1
+
+    while len(out) % 4 != 0:
+        out.append(0)
+
+    return bytes(out)
+
+def decompress(data: bytes, offset: int = 0) -> bytes:
+    header = int.from_bytes(data[offset:offset+4], 'little')
+    if header & 0xFF != 0x10:
+        raise Exception("not lz77 data")
+
+    size = header >> 8
+    out = bytearray()
+    i = offset + 4
+    while len(out) < size:
+        flags = data[i]
+        i += 1
+
+        for bit in range(7, -1, -1):
+            if len(out) >= size: break
+
+            if flags & (1 << bit):
+                v = (data[i] << 8) | data[i+1]
+                i += 2
+                n = (v >> 12) + MIN_MATCH
+                j = len(out) - (v & 0xFFF) - 1
+                for k in range(n):
+                    out.append(out[j + k])
+            else:
+                out.append(data[i])
+                i += 1
+
+    return bytes(out[:size])
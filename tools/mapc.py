@@ -9,6 +9,7 @@ import os
 import os.path as path
 import json
 import ioutil
+import lz77
 from typing import BinaryIO, TextIO
 
 FLIPPED_HORIZONTALLY_FLAG  = 0x80000000
@@ -16,6 +17,41 @@ FLIPPED_VERTICALLY_FLAG    = 0x40000000
 FLIPPED_DIAGONALLY_FLAG    = 0x20000000
 ROTATED_HEXAGONAL_120_FLAG = 0x10000000
 
+# header flags. these have to match MAPC_FLAG_* in src/main/mapc.h.
+MAPC_FLAG_LZ77 = 1
+
+# entity type ids. the order has to match mapc_ent_type_e in src/main/mapc.h.
+ENTITY_TYPES = [
+    'player',
+    'crawler',
+    'gun_enemy',
+    'ceil_gun_enemy',
+    'ice_block',
+    'spring',
+    'super_spring',
+    'home',
+    'sign',
+    'hint_sign',
+    'water_tank',
+    'static_fragile_block',
+    'red_orb',
+    'blue_orb',
+    'stalactite',
+    'boss',
+]
+
+GUN_ENEMY_DIRFLAG_L   = 1
+GUN_ENEMY_DIRFLAG_TL  = 2
+GUN_ENEMY_DIRFLAG_T   = 4
+GUN_ENEMY_DIRFLAG_TR  = 8
+GUN_ENEMY_DIRFLAG_R   = 16
+GUN_ENEMY_DIRFLAG_ALL = 0x1F
+
+# sizes of the buffers game.c loads rooms into. they're fixed-size and only
+# checked in debug builds, so rooms that don't fit are rejected here.
+MAX_ROOM_COLLISION_BYTES = 1024 # GAME_COLLISION_MAP_SIZE, 4 tiles per byte
+MAX_ROOM_COLMASK_WORDS = 256    # GAME_COLMASK_SIZE
+
 class Tileset:
     def __init__(self):
         self.data: dict[int, str] = {}
@@ -45,7 +81,63 @@ def parse_tileset(tmx_path: str):
 
     return output
 
-def parse(ifile_path: str, output_file: BinaryIO, tileset: Tileset):
+def parse_gun_enemy_flags(fire_dir: str | None) -> int:
+    if fire_dir is None:
+        return GUN_ENEMY_DIRFLAG_ALL
+
+    flags = 0
+    i = 0
+    while i < len(fire_dir):
+        match fire_dir[i]:
+            case 'L':
+                flags |= GUN_ENEMY_DIRFLAG_L
+            case 'T':
+                next_ch = fire_dir[i+1] if i + 1 < len(fire_dir) else ''
+                if next_ch == 'r':
+                    flags |= GUN_ENEMY_DIRFLAG_TR
+                    i += 1
+                elif next_ch == 'l':
+                    flags |= GUN_ENEMY_DIRFLAG_TL
+                    i += 1
+                # the game has always fired straight up for these too
+                flags |= GUN_ENEMY_DIRFLAG_T
+            case 'R':
+                flags |= GUN_ENEMY_DIRFLAG_R
+        i += 1
+
+    return flags
+
+def find_chat(chat_ids: list[str] | None, name: str | None, ent_name: str) -> int:
+    if name is None:
+        return -1
+
+    if chat_ids is None:
+        raise Exception(f"{ent_name} needs --dialogue to look up '{name}'")
+
+    # the game only stores the first 16 characters of chat ids
+    for i, chat_id in enumerate(chat_ids):
+        if chat_id[:16] == name[:16]:
+            return i
+
+    raise Exception(f"{ent_name}: could not find chat '{name}'")
+
+# returns the value of the entity's arg field, per mapc_spawn_s
+def resolve_spawn_arg(ent_name: str, props: dict[str, str],
+                      chat_ids: list[str] | None) -> int:
+    match ent_name:
+        case 'crawler':
+            return int(float(props.get('max_dist', 0)) * 256)
+        case 'gun_enemy' | 'ceil_gun_enemy':
+            return parse_gun_enemy_flags(props.get('fire_dir'))
+        case 'sign' | 'hint_sign':
+            return find_chat(chat_ids, props.get('text'), ent_name)
+        case 'stalactite':
+            return int(props.get('variant', 1))
+        case _:
+            return 0
+
+def parse(ifile_path: str, output_file: BinaryIO, tileset: Tileset,
+          chat_ids: list[str] | None, compress: bool):
     with open(ifile_path, 'r') as ifile:
         file_contents = ifile.read()
     
@@ -67,6 +159,14 @@ def parse(ifile_path: str, output_file: BinaryIO, tileset: Tileset):
     map_width = int(layer.get('width'))
     map_height = int(layer.get('height'))
 
+    if (map_width * map_height + 3) // 4 > MAX_ROOM_COLLISION_BYTES:
+        raise Exception(f"map is {map_width}x{map_height}, which is too many "
+                        f"tiles to fit in the collision buffer")
+
+    if (map_width + 31) // 32 * map_height > MAX_ROOM_COLMASK_WORDS:
+        raise Exception(f"map is {map_width}x{map_height}, which is too large "
+                        f"to fit in the collision masks")
+
     data_base64 = layer.find('data')
     if data_base64 is None:
         raise Exception("tile layer has no data")
@@ -77,8 +177,9 @@ def parse(ifile_path: str, output_file: BinaryIO, tileset: Tileset):
     data = base64.b64decode(data_base64.text.strip())
 
     room_name = path.splitext(path.basename(ifile_path))[0]
-    output_file.write(struct.pack('<HHBxxx', map_width, map_height,
-                                  1 if is_outdoors else 0))
+    output_file.write(struct.pack('<HHBBxx', map_width, map_height,
+                                  1 if is_outdoors else 0,
+                                  MAPC_FLAG_LZ77 if compress else 0))
 
     # get collision matrix
     col_data: list[int] = []
@@ -161,6 +262,10 @@ def parse(ifile_path: str, output_file: BinaryIO, tileset: Tileset):
         
         gfx_data += struct.pack('<H', out_int)
     
+    if compress:
+        col_bytes = lz77.compress(col_bytes)
+        gfx_data = lz77.compress(gfx_data)
+
     obj_tmx = tmx_data.find('objectgroup')
     ent_data = None
     if obj_tmx is not None:
@@ -173,51 +278,28 @@ def parse(ifile_path: str, output_file: BinaryIO, tileset: Tileset):
                 entities.append(ent)
 
         # write entity count
-        ent_data += struct.pack('<H', len(entities))
+        ent_data += struct.pack('<Hxx', len(entities))
 
-        # write entity data
+        # write spawn records
         for ent in entities:
             ent_name = ent.get('name')
+            if ent_name not in ENTITY_TYPES:
+                raise Exception("unknown entity type " + ent_name)
 
-            odata = bytearray()
-            odata += struct.pack('<HHHH', int(float(ent.get('x'))),
-                                 int(float(ent.get('y'))),
-                                 int(ent.get('width')), int(ent.get('height')))
-            name_bytes = bytes(ent_name, 'ascii')
-            odata += name_bytes
-            odata.append(0)
-
+            props: dict[str, str] = {}
             prop_tag = ent.find('properties')
             if prop_tag is not None:
-                ent_props = prop_tag.findall('property')
-                odata += struct.pack('<B', len(ent_props))
-
-                for prop in ent_props:
-                    odata += bytes(prop.get('name'), 'ascii')
-                    odata.append(0)
-
-                    match prop.get('type', 'string'):
-                        case 'string':
-                            odata.append(0)
-                            odata += bytes(prop.get('value'), 'ascii')
-                            odata.append(0)
-
-                        case 'int':
-                            odata.append(1)
-                            odata += struct.pack('<I', int(prop.get('value')))
-
-                        case 'float':
-                            odata.append(2)
-                            fx_val = int(float(prop.get('value')) * 256)
-                            odata += struct.pack('<I', fx_val)                        
-
-                        case t:
-                            raise Exception("unknown property type " + t)
-            else:
-                odata += struct.pack('<B', 0)
-
-            ent_data += struct.pack('<H', len(odata))
-            ent_data += odata
+                for prop in prop_tag.findall('property'):
+                    props[prop.get('name')] = prop.get('value')
+
+            arg = resolve_spawn_arg(ent_name, props, chat_ids)
+            ent_data += struct.pack('<Bxhhhhxxi',
+                                    ENTITY_TYPES.index(ent_name),
+                                    int(float(ent.get('x'))),
+                                    int(float(ent.get('y'))),
+                                    int(ent.get('width')),
+                                    int(ent.get('height')),
+                                    arg)
     
     section_offset = 20
     output_file.write(struct.pack('<I', section_offset)) # col offset
@@ -255,6 +337,8 @@ def main():
     parser = argparse.ArgumentParser(prog='mapc')
     parser.add_argument('input', help="path to input tmx file.")
     parser.add_argument('output', help="output bin file. pass - to write to stdout.")
+    parser.add_argument('--dialogue', help="path to dialogue.json, for looking up the chats of signs.")
+    parser.add_argument('--no-compress', action='store_true', help="write the collision and graphics uncompressed.")
 
     args = parser.parse_args()
 
@@ -262,7 +346,13 @@ def main():
 
     s = False
     try:
-        parse(args.input, out_file, parse_tileset(args.input))
+        chat_ids = None
+        if args.dialogue:
+            with open(args.dialogue, 'r') as dlg_file:
+                chat_ids = [chat['id'] for chat in json.load(dlg_file)]
+
+        parse(args.input, out_file, parse_tileset(args.input), chat_ids,
+              not args.no_compress)
         s = True
     finally:
         if not s:
@@ -6,6 +6,7 @@ import json
 import typing
 import struct
 import ioutil
+import lz77
 import xml.etree.ElementTree as xml
 
 ROOM_SCREEN_WIDTH = 15
@@ -25,6 +26,9 @@ ADJBIT_TL = 0x20
 ADJBIT_BL = 0x40
 ADJBIT_BR = 0x80
 
+# has to match MAPC_FLAG_LZ77 in tools/mapc.py
+MAPC_FLAG_LZ77 = 1
+
 g_errors: list[Exception] = []
 
 class RoomData:
@@ -369,13 +373,18 @@ def calc_room_automap_occupancy(room_path: str) -> Array2D:
     with open('data/maps/' + room_path + '.map', 'rb') as map_file:
         map_data = map_file.read()
     
-    (room_width, room_height, _, col_data_offset, _, _) = \
-        struct.unpack('<HHBxxxIII', map_data[0:20])
+    (room_width, room_height, _, flags, col_data_offset, _, _) = \
+        struct.unpack('<HHBBxxIII', map_data[0:20])
+
+    if flags & MAPC_FLAG_LZ77:
+        col_bytes = lz77.decompress(map_data, col_data_offset)
+    else:
+        col_bytes = map_data[col_data_offset:]
     
     col_data = bytearray(int_ceil_div(room_width * room_height, 4) * 4)
     j = 0
     for i in range(0, int_ceil_div(room_width * room_height, 4)):
-        byte = map_data[col_data_offset + i]
+        byte = col_bytes[i]
         col_data[j  ] = byte & 0x3
         col_data[j+1] = (byte >> 2) & 0x3
         col_data[j+2] = (byte >> 4) & 0x3